@@ -0,0 +1,524 @@
+#include "dq_async.hpp"
+#include "dq_executor.hpp"
+#include "dq_metrics.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/storage/object_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace duckdb {
+
+// A suite running in the background, shared between the worker thread and the status/cancel functions
+struct DQAsyncExecution {
+	string execution_id;
+	DQRunProgress progress;
+	std::chrono::steady_clock::time_point started_at;
+	//! Average historical execution time of each test of the suite, in run order (-1 when unknown)
+	vector<int64_t> expected_ms;
+	//! Thread running the suite; joined by the DQExecutionRegistry that owns the execution once it finished
+	std::thread worker;
+
+	mutex lock;
+	std::condition_variable state_changed;
+	string state = "running"; // 'running', 'completed', 'cancelled', 'failed'
+	string error_message;
+	std::chrono::steady_clock::time_point finished_at;
+};
+
+//! Background executions of one database, stored in its ObjectCache. Workers only hold the database weakly, so
+//! closing it destroys the registry, which cancels the executions that are still running. Finished executions stay
+//! queryable until more than MAX_FINISHED_EXECUTIONS have accumulated, then the oldest are evicted.
+class DQExecutionRegistry : public ObjectCacheEntry {
+public:
+	static constexpr idx_t MAX_FINISHED_EXECUTIONS = 64;
+
+	~DQExecutionRegistry() override {
+		for (auto &entry : executions) {
+			entry.second->progress.cancel_requested = true;
+		}
+		for (auto &entry : executions) {
+			auto &execution = *entry.second;
+			bool running;
+			{
+				lock_guard<mutex> guard(execution.lock);
+				running = execution.state == "running";
+			}
+			if (running && execution.worker.joinable()) {
+				// The database may be closing on one of the suite's own threads, so waiting here could deadlock. The
+				// worker only touches the execution it shares from now on: its pool reports the database as closed.
+				execution.worker.detach();
+			} else {
+				JoinWorker(execution);
+			}
+		}
+	}
+
+	static shared_ptr<DQExecutionRegistry> Get(ClientContext &context) {
+		return ObjectCache::GetObjectCache(context).GetOrCreate<DQExecutionRegistry>(ObjectType());
+	}
+
+	static string ObjectType() {
+		return "dq_execution_registry";
+	}
+
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	//! The registry is never evicted from the ObjectCache, it owns running threads
+	optional_idx GetEstimatedCacheMemory() const override {
+		return optional_idx();
+	}
+
+	void Register(shared_ptr<DQAsyncExecution> execution) {
+		vector<shared_ptr<DQAsyncExecution>> evicted;
+		{
+			lock_guard<mutex> guard(lock);
+			executions[execution->execution_id] = std::move(execution);
+			evicted = EvictFinished();
+		}
+		// Evicted workers are done or about to return, so joining them outside the lock is short
+		for (auto &old_execution : evicted) {
+			JoinWorker(*old_execution);
+		}
+	}
+
+	shared_ptr<DQAsyncExecution> Find(const string &execution_id) {
+		lock_guard<mutex> guard(lock);
+		auto entry = executions.find(execution_id);
+		if (entry == executions.end()) {
+			throw InvalidInputException("Unknown execution_id: " + execution_id);
+		}
+		return entry->second;
+	}
+
+private:
+	static void JoinWorker(DQAsyncExecution &execution) {
+		if (!execution.worker.joinable()) {
+			return;
+		}
+		if (execution.worker.get_id() == std::this_thread::get_id()) {
+			// The worker released the last reference to the database; it returns right after this
+			execution.worker.detach();
+		} else {
+			execution.worker.join();
+		}
+	}
+
+	vector<shared_ptr<DQAsyncExecution>> EvictFinished() {
+		vector<shared_ptr<DQAsyncExecution>> finished;
+		for (auto &entry : executions) {
+			lock_guard<mutex> guard(entry.second->lock);
+			if (entry.second->state != "running") {
+				finished.push_back(entry.second);
+			}
+		}
+		if (finished.size() <= MAX_FINISHED_EXECUTIONS) {
+			return vector<shared_ptr<DQAsyncExecution>>();
+		}
+		std::sort(finished.begin(), finished.end(),
+		          [](const shared_ptr<DQAsyncExecution> &a, const shared_ptr<DQAsyncExecution> &b) {
+			          return a->finished_at < b->finished_at;
+		          });
+		finished.resize(finished.size() - MAX_FINISHED_EXECUTIONS);
+		for (auto &execution : finished) {
+			executions.erase(execution->execution_id);
+		}
+		return finished;
+	}
+
+	mutex lock;
+	unordered_map<string, shared_ptr<DQAsyncExecution>> executions;
+};
+
+static vector<int64_t> LoadExpectedTimes(Connection &con, const vector<DQTestDefinition> &tests) {
+	vector<int64_t> expected_ms(tests.size(), -1);
+	if (tests.empty()) {
+		return expected_ms;
+	}
+
+	string id_list;
+	for (auto &test : tests) {
+		if (!id_list.empty()) {
+			id_list += ", ";
+		}
+		id_list += Value(test.test_id).ToSQLString();
+	}
+	auto result = con.Query("SELECT test_id, avg(execution_time_ms)::BIGINT FROM dq_test_results WHERE test_id IN (" +
+	                        id_list + ") GROUP BY test_id");
+	if (result->HasError()) {
+		return expected_ms;
+	}
+
+	unordered_map<string, int64_t> history;
+	while (true) {
+		auto chunk = result->Fetch();
+		if (!chunk || chunk->size() == 0) {
+			break;
+		}
+		for (idx_t i = 0; i < chunk->size(); i++) {
+			history[chunk->GetValue(0, i).ToString()] = chunk->GetValue(1, i).GetValue<int64_t>();
+		}
+	}
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto entry = history.find(tests[i].test_id);
+		if (entry != history.end()) {
+			expected_ms[i] = entry->second;
+		}
+	}
+	return expected_ms;
+}
+
+//===--------------------------------------------------------------------===//
+// dq_run_tests_async
+//===--------------------------------------------------------------------===//
+struct RunTestsAsyncBindData : public FunctionData {
+	DQTestFilter filter;
+	DQRunOptions options;
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto result = make_uniq<RunTestsAsyncBindData>();
+		result->filter = filter;
+		result->options = options;
+		return result;
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<RunTestsAsyncBindData>();
+		return filter.table_name == other.filter.table_name && filter.tag == other.filter.tag &&
+		       filter.test_id == other.filter.test_id &&
+		       options.materialize_views == other.options.materialize_views &&
+		       options.sample_threshold.IsValid() == other.options.sample_threshold.IsValid() &&
+		       (!options.sample_threshold.IsValid() ||
+		        options.sample_threshold.GetIndex() == other.options.sample_threshold.GetIndex());
+	}
+};
+
+struct RunTestsAsyncGlobalState : public GlobalTableFunctionState {
+	string execution_id;
+	idx_t tests_total = 0;
+	bool finished = false;
+
+	idx_t MaxThreads() const override {
+		return 1;
+	}
+};
+
+static unique_ptr<FunctionData> RunTestsAsyncBind(ClientContext &context, TableFunctionBindInput &input,
+                                                  vector<LogicalType> &return_types, vector<string> &names) {
+	auto bind_data = make_uniq<RunTestsAsyncBindData>();
+
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "table_name") {
+			bind_data->filter.table_name = StringValue::Get(kv.second);
+		} else if (kv.first == "tag") {
+			bind_data->filter.tag = StringValue::Get(kv.second);
+		} else if (kv.first == "test_id") {
+			bind_data->filter.test_id = StringValue::Get(kv.second);
+		} else if (kv.first == "materialize_views") {
+			bind_data->options.materialize_views = BooleanValue::Get(kv.second);
+		} else if (kv.first == "sample_threshold" && !kv.second.IsNull()) {
+			bind_data->options.sample_threshold = optional_idx(kv.second.GetValue<idx_t>());
+		}
+	}
+
+	names.push_back("execution_id");
+	names.push_back("tests_total");
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::BIGINT);
+
+	return bind_data;
+}
+
+static unique_ptr<GlobalTableFunctionState> RunTestsAsyncGlobalInit(ClientContext &context,
+                                                                    TableFunctionInitInput &input) {
+	auto state = make_uniq<RunTestsAsyncGlobalState>();
+	auto &bind_data = input.bind_data->Cast<RunTestsAsyncBindData>();
+
+	Connection con(*context.db);
+	auto tests = DQExecutor::LoadTests(con, bind_data.filter);
+
+	auto execution = make_shared_ptr<DQAsyncExecution>();
+	execution->execution_id = DQExecutor::GenerateExecutionId(con);
+	execution->expected_ms = LoadExpectedTimes(con, tests);
+	execution->progress.tests_total = tests.size();
+	execution->started_at = std::chrono::steady_clock::now();
+
+	state->execution_id = execution->execution_id;
+	state->tests_total = tests.size();
+
+	// The worker outlives the calling connection but holds the database only weakly: closing the database cancels
+	// the suite, which then stops before its next query
+	auto options = bind_data.options;
+	options.metrics_path = DQMetrics::GetMetricsPath(context);
+	options.hold_database = false;
+	weak_ptr<DatabaseInstance> db = context.db;
+	execution->worker = std::thread([db, execution, tests, options]() {
+		string final_state = "completed";
+		string error_message;
+		try {
+			DQExecutor::RunSuite(db, tests, execution->execution_id, &execution->progress, options);
+			if (execution->progress.cancel_requested &&
+			    execution->progress.tests_done < execution->progress.tests_total) {
+				final_state = "cancelled";
+			}
+		} catch (std::exception &e) {
+			final_state = "failed";
+			error_message = e.what();
+		}
+		{
+			lock_guard<mutex> guard(execution->lock);
+			execution->state = final_state;
+			execution->error_message = error_message;
+			execution->finished_at = std::chrono::steady_clock::now();
+		}
+		execution->state_changed.notify_all();
+	});
+	DQExecutionRegistry::Get(context)->Register(execution);
+
+	return state;
+}
+
+static void RunTestsAsyncFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<RunTestsAsyncGlobalState>();
+
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(global_state.execution_id));
+	output.data[1].SetValue(0, Value::BIGINT(static_cast<int64_t>(global_state.tests_total)));
+	global_state.finished = true;
+}
+
+//===--------------------------------------------------------------------===//
+// dq_execution_status / dq_cancel
+//===--------------------------------------------------------------------===//
+struct ExecutionIdBindData : public FunctionData {
+	string execution_id;
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto result = make_uniq<ExecutionIdBindData>();
+		result->execution_id = execution_id;
+		return result;
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		return execution_id == other_p.Cast<ExecutionIdBindData>().execution_id;
+	}
+};
+
+struct ExecutionIdGlobalState : public GlobalTableFunctionState {
+	bool finished = false;
+
+	idx_t MaxThreads() const override {
+		return 1;
+	}
+};
+
+static unique_ptr<GlobalTableFunctionState> ExecutionIdGlobalInit(ClientContext &context,
+                                                                  TableFunctionInitInput &input) {
+	return make_uniq<ExecutionIdGlobalState>();
+}
+
+static unique_ptr<FunctionData> ExecutionStatusBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	auto bind_data = make_uniq<ExecutionIdBindData>();
+	bind_data->execution_id = StringValue::Get(input.inputs[0]);
+
+	names.push_back("execution_id");
+	names.push_back("state");
+	names.push_back("tests_done");
+	names.push_back("tests_total");
+	names.push_back("elapsed_ms");
+	names.push_back("eta_ms");
+	names.push_back("error_message");
+
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::VARCHAR);
+
+	return bind_data;
+}
+
+static void ExecutionStatusFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<ExecutionIdGlobalState>();
+	auto &bind_data = data.bind_data->Cast<ExecutionIdBindData>();
+
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto execution = DQExecutionRegistry::Get(context)->Find(bind_data.execution_id);
+	idx_t tests_done = execution->progress.tests_done;
+	idx_t tests_total = execution->progress.tests_total;
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+	                                                                        execution->started_at)
+	                      .count();
+
+	string state;
+	string error_message;
+	{
+		lock_guard<mutex> guard(execution->lock);
+		state = execution->state;
+		error_message = execution->error_message;
+	}
+
+	// ETA: historical average of the remaining tests; tests without history count as the average of those with
+	Value eta;
+	if (state == "running") {
+		int64_t known_sum = 0;
+		idx_t known_count = 0;
+		for (auto ms : execution->expected_ms) {
+			if (ms >= 0) {
+				known_sum += ms;
+				known_count++;
+			}
+		}
+		if (known_count > 0) {
+			int64_t fallback_ms = known_sum / static_cast<int64_t>(known_count);
+			int64_t remaining_ms = 0;
+			for (idx_t i = tests_done; i < execution->expected_ms.size(); i++) {
+				auto ms = execution->expected_ms[i];
+				remaining_ms += ms >= 0 ? ms : fallback_ms;
+			}
+			eta = Value::BIGINT(remaining_ms);
+		}
+	} else {
+		eta = Value::BIGINT(0);
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(execution->execution_id));
+	output.data[1].SetValue(0, Value(state));
+	output.data[2].SetValue(0, Value::BIGINT(static_cast<int64_t>(tests_done)));
+	output.data[3].SetValue(0, Value::BIGINT(static_cast<int64_t>(tests_total)));
+	output.data[4].SetValue(0, Value::BIGINT(elapsed_ms));
+	output.data[5].SetValue(0, eta);
+	output.data[6].SetValue(0, error_message.empty() ? Value() : Value(error_message));
+	global_state.finished = true;
+}
+
+static unique_ptr<FunctionData> CancelBind(ClientContext &context, TableFunctionBindInput &input,
+                                           vector<LogicalType> &return_types, vector<string> &names) {
+	auto bind_data = make_uniq<ExecutionIdBindData>();
+	bind_data->execution_id = StringValue::Get(input.inputs[0]);
+
+	names.push_back("status");
+	return_types.push_back(LogicalType::VARCHAR);
+
+	return bind_data;
+}
+
+static void CancelFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<ExecutionIdGlobalState>();
+	auto &bind_data = data.bind_data->Cast<ExecutionIdBindData>();
+
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto execution = DQExecutionRegistry::Get(context)->Find(bind_data.execution_id);
+	string status;
+	{
+		lock_guard<mutex> guard(execution->lock);
+		if (execution->state == "running") {
+			// The worker stops before its next test; completed results are already stored
+			execution->progress.cancel_requested = true;
+			status = "CANCELLING: " + execution->execution_id;
+		} else {
+			status = "NOT RUNNING: execution is " + execution->state;
+		}
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(status));
+	global_state.finished = true;
+}
+
+//===--------------------------------------------------------------------===//
+// dq_wait
+//===--------------------------------------------------------------------===//
+static unique_ptr<FunctionData> WaitBind(ClientContext &context, TableFunctionBindInput &input,
+                                         vector<LogicalType> &return_types, vector<string> &names) {
+	auto bind_data = make_uniq<ExecutionIdBindData>();
+	bind_data->execution_id = StringValue::Get(input.inputs[0]);
+
+	names.push_back("execution_id");
+	names.push_back("state");
+	names.push_back("tests_done");
+	names.push_back("tests_total");
+	names.push_back("error_message");
+
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::VARCHAR);
+
+	return bind_data;
+}
+
+static void WaitFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<ExecutionIdGlobalState>();
+	auto &bind_data = data.bind_data->Cast<ExecutionIdBindData>();
+
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto execution = DQExecutionRegistry::Get(context)->Find(bind_data.execution_id);
+	string state;
+	string error_message;
+	{
+		unique_lock<mutex> guard(execution->lock);
+		execution->state_changed.wait(guard, [&]() { return execution->state != "running"; });
+		state = execution->state;
+		error_message = execution->error_message;
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(execution->execution_id));
+	output.data[1].SetValue(0, Value(state));
+	output.data[2].SetValue(0, Value::BIGINT(static_cast<int64_t>(execution->progress.tests_done.load())));
+	output.data[3].SetValue(0, Value::BIGINT(static_cast<int64_t>(execution->progress.tests_total.load())));
+	output.data[4].SetValue(0, error_message.empty() ? Value() : Value(error_message));
+	global_state.finished = true;
+}
+
+void RegisterDQAsyncFunctions(ExtensionLoader &loader) {
+	TableFunction run_tests_async_func("dq_run_tests_async", {}, RunTestsAsyncFunc, RunTestsAsyncBind,
+	                                   RunTestsAsyncGlobalInit);
+	run_tests_async_func.named_parameters["table_name"] = LogicalType::VARCHAR;
+	run_tests_async_func.named_parameters["tag"] = LogicalType::VARCHAR;
+	run_tests_async_func.named_parameters["test_id"] = LogicalType::VARCHAR;
+	run_tests_async_func.named_parameters["materialize_views"] = LogicalType::BOOLEAN;
+	run_tests_async_func.named_parameters["sample_threshold"] = LogicalType::UBIGINT;
+	loader.RegisterFunction(run_tests_async_func);
+
+	TableFunction status_func("dq_execution_status", {LogicalType::VARCHAR}, ExecutionStatusFunc, ExecutionStatusBind,
+	                          ExecutionIdGlobalInit);
+	loader.RegisterFunction(status_func);
+
+	TableFunction cancel_func("dq_cancel", {LogicalType::VARCHAR}, CancelFunc, CancelBind, ExecutionIdGlobalInit);
+	loader.RegisterFunction(cancel_func);
+
+	TableFunction wait_func("dq_wait", {LogicalType::VARCHAR}, WaitFunc, WaitBind, ExecutionIdGlobalInit);
+	loader.RegisterFunction(wait_func);
+}
+
+} // namespace duckdb
@@ -23,6 +23,9 @@ string DQCompiler::CompileTest(const string &test_type, const string &table_name
 		return CompileRowCount(table_name, test_params_json);
 	} else if (test_type == "custom_sql") {
 		return CompileCustomSQL(table_name, column_name, test_params_json);
+	} else if (IsDriftTest(test_type)) {
+		// Drift tests return the profile metric rather than failing rows
+		return "SELECT " + CompileDriftMetric(test_type, column_name, test_params_json) + " FROM " + table_name;
 	} else {
 		throw InvalidInputException("Unknown test type: " + test_type);
 	}
@@ -39,6 +42,11 @@ string DQCompiler::CompileNotNull(const string &table_name, const string &column
 
 string DQCompiler::CompileAcceptedValues(const string &table_name, const string &column_name,
                                          const string &test_params_json) {
+	return "SELECT * FROM " + table_name + " WHERE " +
+	       CompileFailurePredicate("accepted_values", column_name, test_params_json);
+}
+
+string DQCompiler::ExtractAcceptedValues(const string &test_params_json) {
 	// Parse JSON to extract values array
 	// For now, simple implementation - in production, use proper JSON parsing
 	// Expected format: {"values": ["a", "b", "c"]}
@@ -60,11 +68,14 @@ string DQCompiler::CompileAcceptedValues(const string &table_name, const string
 		pos += 1;
 	}
 
-	return "SELECT * FROM " + table_name + " WHERE " + column_name + " NOT IN (" + values_list + ") OR " + column_name +
-	       " IS NULL";
+	return values_list;
 }
 
 string DQCompiler::CompileRegex(const string &table_name, const string &column_name, const string &test_params_json) {
+	return "SELECT * FROM " + table_name + " WHERE " + CompileFailurePredicate("regex", column_name, test_params_json);
+}
+
+string DQCompiler::ExtractRegexPattern(const string &test_params_json) {
 	// Extract pattern from JSON
 	// Expected format: {"pattern": "^[A-Z]{2}[0-9]+$"}
 	auto pattern_start = test_params_json.find("\"pattern\"");
@@ -74,58 +85,48 @@ string DQCompiler::CompileRegex(const string &table_name, const string &column_n
 
 	auto colon_pos = test_params_json.find(":", pattern_start);
 	auto value_start = test_params_json.find("\"", colon_pos + 1);
-	auto value_end = test_params_json.find("\"", value_start + 1);
-
-	string pattern = test_params_json.substr(value_start + 1, value_end - value_start - 1);
+	if (colon_pos == string::npos || value_start == string::npos) {
+		throw InvalidInputException("Invalid test_params for regex: 'pattern' must be a string");
+	}
 
-	return "SELECT * FROM " + table_name + " WHERE NOT regexp_matches(" + column_name + ", '" + pattern + "')";
+	// Undo the JSON string escapes, so "\\." in the params is the regex \. (a literal dot)
+	string pattern;
+	for (auto pos = value_start + 1; pos < test_params_json.size(); pos++) {
+		auto c = test_params_json[pos];
+		if (c == '"') {
+			return pattern;
+		}
+		if (c == '\\' && pos + 1 < test_params_json.size()) {
+			auto next = test_params_json[pos + 1];
+			if (next == '\\' || next == '"' || next == '/') {
+				c = next;
+				pos++;
+			}
+		}
+		pattern += c;
+	}
+	throw InvalidInputException("Invalid test_params for regex: unterminated 'pattern'");
 }
 
 string DQCompiler::CompileRange(const string &table_name, const string &column_name, const string &test_params_json) {
-	// Extract min and max from JSON
-	// Expected format: {"min": 0, "max": 100}
+	return "SELECT * FROM " + table_name + " WHERE " + CompileFailurePredicate("range", column_name, test_params_json);
+}
 
+string DQCompiler::ExtractNumericParam(const string &test_params_json, const string &key, const string &default_value) {
 	// Simple extraction (should use proper JSON parsing)
-	auto min_start = test_params_json.find("\"min\"");
-	auto max_start = test_params_json.find("\"max\"");
-
-	string min_val = "NULL";
-	string max_val = "NULL";
-
-	if (min_start != string::npos) {
-		auto colon = test_params_json.find(":", min_start);
-		auto comma_or_end = test_params_json.find_first_of(",}", colon);
-		min_val = test_params_json.substr(colon + 1, comma_or_end - colon - 1);
-		// Trim whitespace
-		min_val.erase(0, min_val.find_first_not_of(" \t\n\r"));
-		min_val.erase(min_val.find_last_not_of(" \t\n\r") + 1);
-	}
-
-	if (max_start != string::npos) {
-		auto colon = test_params_json.find(":", max_start);
-		auto comma_or_end = test_params_json.find_first_of(",}", colon);
-		max_val = test_params_json.substr(colon + 1, comma_or_end - colon - 1);
-		// Trim whitespace
-		max_val.erase(0, max_val.find_first_not_of(" \t\n\r"));
-		max_val.erase(max_val.find_last_not_of(" \t\n\r") + 1);
-	}
-
-	string conditions;
-	if (min_val != "NULL" && min_val != "null") {
-		conditions = column_name + " < " + min_val;
-	}
-	if (max_val != "NULL" && max_val != "null") {
-		if (!conditions.empty()) {
-			conditions += " OR ";
-		}
-		conditions += column_name + " > " + max_val;
-	}
-	if (!conditions.empty()) {
-		conditions += " OR ";
+	// Expected format: {"min": 0, "max": 100}
+	auto key_start = test_params_json.find("\"" + key + "\"");
+	if (key_start == string::npos) {
+		return default_value;
 	}
-	conditions += column_name + " IS NULL";
 
-	return "SELECT * FROM " + table_name + " WHERE " + conditions;
+	auto colon = test_params_json.find(":", key_start);
+	auto comma_or_end = test_params_json.find_first_of(",}", colon);
+	string value = test_params_json.substr(colon + 1, comma_or_end - colon - 1);
+	// Trim whitespace
+	value.erase(0, value.find_first_not_of(" \t\n\r"));
+	value.erase(value.find_last_not_of(" \t\n\r") + 1);
+	return value;
 }
 
 string DQCompiler::CompileRelationship(const string &table_name, const string &column_name,
@@ -133,53 +134,56 @@ string DQCompiler::CompileRelationship(const string &table_name, const string &c
 	// Extract to_table and to_column from JSON
 	// Expected format: {"to_table": "customers", "to_column": "id"}
 
-	auto to_table_start = test_params_json.find("\"to_table\"");
-	auto to_column_start = test_params_json.find("\"to_column\"");
+	string to_table = ExtractStringParam(test_params_json, "to_table");
+	string to_column = ExtractStringParam(test_params_json, "to_column");
 
-	if (to_table_start == string::npos || to_column_start == string::npos) {
+	if (to_table.empty() || to_column.empty()) {
 		throw InvalidInputException("Invalid test_params for relationship: must contain 'to_table' and 'to_column'");
 	}
 
-	// Extract to_table value
-	auto tt_colon = test_params_json.find(":", to_table_start);
-	auto tt_value_start = test_params_json.find("\"", tt_colon + 1);
-	auto tt_value_end = test_params_json.find("\"", tt_value_start + 1);
-	string to_table = test_params_json.substr(tt_value_start + 1, tt_value_end - tt_value_start - 1);
-
-	// Extract to_column value
-	auto tc_colon = test_params_json.find(":", to_column_start);
-	auto tc_value_start = test_params_json.find("\"", tc_colon + 1);
-	auto tc_value_end = test_params_json.find("\"", tc_value_start + 1);
-	string to_column = test_params_json.substr(tc_value_start + 1, tc_value_end - tc_value_start - 1);
-
 	return "SELECT t.* FROM " + table_name + " t WHERE t." + column_name +
 	       " IS NOT NULL AND NOT EXISTS (SELECT 1 FROM " + to_table + " r WHERE r." + to_column + " = t." +
 	       column_name + ")";
 }
 
-string DQCompiler::CompileRowCount(const string &table_name, const string &test_params_json) {
-	// Extract min and max from JSON
-	auto min_start = test_params_json.find("\"min\"");
-	auto max_start = test_params_json.find("\"max\"");
+string DQCompiler::ExtractStringParam(const string &test_params_json, const string &key) {
+	auto key_start = test_params_json.find("\"" + key + "\"");
+	if (key_start == string::npos) {
+		return "";
+	}
 
-	string min_val = "0";
-	string max_val = "NULL";
+	auto colon = test_params_json.find(":", key_start);
+	auto value_start = test_params_json.find("\"", colon + 1);
+	auto value_end = test_params_json.find("\"", value_start + 1);
+	if (colon == string::npos || value_start == string::npos || value_end == string::npos) {
+		return "";
+	}
+	return test_params_json.substr(value_start + 1, value_end - value_start - 1);
+}
 
-	if (min_start != string::npos) {
-		auto colon = test_params_json.find(":", min_start);
-		auto comma_or_end = test_params_json.find_first_of(",}", colon);
-		min_val = test_params_json.substr(colon + 1, comma_or_end - colon - 1);
-		min_val.erase(0, min_val.find_first_not_of(" \t\n\r"));
-		min_val.erase(min_val.find_last_not_of(" \t\n\r") + 1);
+string DQCompiler::ReplaceStringParam(const string &test_params_json, const string &key, const string &value) {
+	auto key_start = test_params_json.find("\"" + key + "\"");
+	if (key_start == string::npos) {
+		return test_params_json;
 	}
 
-	if (max_start != string::npos) {
-		auto colon = test_params_json.find(":", max_start);
-		auto comma_or_end = test_params_json.find_first_of(",}", colon);
-		max_val = test_params_json.substr(colon + 1, comma_or_end - colon - 1);
-		max_val.erase(0, max_val.find_first_not_of(" \t\n\r"));
-		max_val.erase(max_val.find_last_not_of(" \t\n\r") + 1);
+	auto colon = test_params_json.find(":", key_start);
+	auto value_start = test_params_json.find("\"", colon + 1);
+	auto value_end = test_params_json.find("\"", value_start + 1);
+	if (colon == string::npos || value_start == string::npos || value_end == string::npos) {
+		return test_params_json;
 	}
+	return test_params_json.substr(0, value_start + 1) + value + test_params_json.substr(value_end);
+}
+
+string DQCompiler::CompileRowCount(const string &table_name, const string &test_params_json) {
+	return "SELECT * FROM (SELECT CASE WHEN " + CompileRowCountCondition(test_params_json) +
+	       " THEN 1 ELSE 0 END AS fails FROM " + table_name + ") WHERE fails = 1";
+}
+
+string DQCompiler::CompileRowCountCondition(const string &test_params_json) {
+	string min_val = ExtractNumericParam(test_params_json, "min", "0");
+	string max_val = ExtractNumericParam(test_params_json, "max", "NULL");
 
 	string conditions;
 	if (min_val != "NULL" && min_val != "null") {
@@ -191,9 +195,10 @@ string DQCompiler::CompileRowCount(const string &table_name, const string &test_
 		}
 		conditions += "COUNT(*) > " + max_val;
 	}
-
-	return "SELECT * FROM (SELECT CASE WHEN " + conditions + " THEN 1 ELSE 0 END AS fails FROM " + table_name +
-	       ") WHERE fails = 1";
+	if (conditions.empty()) {
+		conditions = "false";
+	}
+	return conditions;
 }
 
 string DQCompiler::CompileCustomSQL(const string &table_name, const string &column_name,
@@ -215,6 +220,152 @@ string DQCompiler::CompileCustomSQL(const string &table_name, const string &colu
 	return SubstituteVariables(sql, table_name, column_name);
 }
 
+bool DQCompiler::IsPredicateTest(const string &test_type) {
+	return test_type == "not_null" || test_type == "accepted_values" || test_type == "regex" || test_type == "range";
+}
+
+string DQCompiler::CompileFailurePredicate(const string &test_type, const string &column_name,
+                                           const string &test_params_json) {
+	if (test_type == "not_null") {
+		return column_name + " IS NULL";
+	} else if (test_type == "accepted_values") {
+		return column_name + " NOT IN (" + ExtractAcceptedValues(test_params_json) + ") OR " + column_name +
+		       " IS NULL";
+	} else if (test_type == "regex") {
+		return "NOT regexp_matches(" + column_name + ", " + Value(ExtractRegexPattern(test_params_json)).ToSQLString() +
+		       ")";
+	} else if (test_type == "range") {
+		string min_val = ExtractNumericParam(test_params_json, "min", "NULL");
+		string max_val = ExtractNumericParam(test_params_json, "max", "NULL");
+
+		string conditions;
+		if (min_val != "NULL" && min_val != "null") {
+			conditions = column_name + " < " + min_val;
+		}
+		if (max_val != "NULL" && max_val != "null") {
+			if (!conditions.empty()) {
+				conditions += " OR ";
+			}
+			conditions += column_name + " > " + max_val;
+		}
+		if (!conditions.empty()) {
+			conditions += " OR ";
+		}
+		conditions += column_name + " IS NULL";
+		return conditions;
+	}
+	throw InvalidInputException("Test type '" + test_type + "' has no row-level failure predicate");
+}
+
+string DQCompiler::CompileFailureAggregate(const string &test_type, const string &column_name,
+                                           const string &test_params_json, bool grouped) {
+	if (grouped) {
+		// Input rows are (column_name, __dq_cnt) pairs produced by GROUP BY column_name
+		if (test_type == "unique") {
+			return "COUNT(*) FILTER (WHERE __dq_cnt > 1)";
+		}
+		if (IsPredicateTest(test_type)) {
+			return "COALESCE(SUM(__dq_cnt) FILTER (WHERE " +
+			       CompileFailurePredicate(test_type, column_name, test_params_json) + "), 0)";
+		}
+		return "";
+	}
+	if (IsPredicateTest(test_type)) {
+		return "COUNT(*) FILTER (WHERE " + CompileFailurePredicate(test_type, column_name, test_params_json) + ")";
+	}
+	if (test_type == "row_count") {
+		return "CASE WHEN " + CompileRowCountCondition(test_params_json) + " THEN 1 ELSE 0 END";
+	}
+	return "";
+}
+
+string DQCompiler::CompileSegmentLabel(const vector<string> &group_columns, const string &qualifier) {
+	// Renders e.g. "tenant_id=42, region=eu" so segments stay readable in the results table
+	string label;
+	for (auto &column : group_columns) {
+		if (!label.empty()) {
+			label += " || ', ' || ";
+		}
+		label += "'" + column + "=' || COALESCE(CAST(" + qualifier + column + " AS VARCHAR), 'NULL')";
+	}
+	return label;
+}
+
+string DQCompiler::CompileSegmentedTest(const string &test_type, const string &table_name, const string &column_name,
+                                        const string &test_params_json, const string &group_by) {
+	vector<string> group_columns;
+	for (auto &column : StringUtil::Split(group_by, ',')) {
+		StringUtil::Trim(column);
+		if (!column.empty()) {
+			group_columns.push_back(column);
+		}
+	}
+	if (group_columns.empty()) {
+		throw InvalidInputException("Invalid group_by: must list at least one column");
+	}
+	string group_list = StringUtil::Join(group_columns, ", ");
+
+	if (test_type == "unique") {
+		return "SELECT " + CompileSegmentLabel(group_columns, "") +
+		       " AS segment, COUNT(*) FILTER (WHERE __dq_cnt > 1) AS rows_failed, SUM(__dq_cnt) AS rows_total FROM "
+		       "(SELECT " +
+		       group_list + ", " + column_name + ", COUNT(*) AS __dq_cnt FROM " + table_name + " GROUP BY " +
+		       group_list + ", " + column_name + ") GROUP BY " + group_list;
+	}
+
+	if (test_type == "relationship") {
+		string to_table = ExtractStringParam(test_params_json, "to_table");
+		string to_column = ExtractStringParam(test_params_json, "to_column");
+		if (to_table.empty() || to_column.empty()) {
+			throw InvalidInputException(
+			    "Invalid test_params for relationship: must contain 'to_table' and 'to_column'");
+		}
+		vector<string> qualified_columns;
+		for (auto &column : group_columns) {
+			qualified_columns.push_back("t." + column);
+		}
+		return "SELECT " + CompileSegmentLabel(group_columns, "t.") + " AS segment, COUNT(*) FILTER (WHERE t." +
+		       column_name + " IS NOT NULL AND r.__dq_key IS NULL) AS rows_failed, COUNT(*) AS rows_total FROM " +
+		       table_name + " t LEFT JOIN (SELECT DISTINCT " + to_column + " AS __dq_key FROM " + to_table +
+		       ") r ON r.__dq_key = t." + column_name + " GROUP BY " + StringUtil::Join(qualified_columns, ", ");
+	}
+
+	auto aggregate = CompileFailureAggregate(test_type, column_name, test_params_json, false);
+	if (aggregate.empty()) {
+		throw InvalidInputException("group_by is not supported for test type: " + test_type);
+	}
+	return "SELECT " + CompileSegmentLabel(group_columns, "") + " AS segment, " + aggregate +
+	       " AS rows_failed, COUNT(*) AS rows_total FROM " + table_name + " GROUP BY " + group_list;
+}
+
+bool DQCompiler::IsDriftTest(const string &test_type) {
+	return test_type == "mean_drift" || test_type == "quantile_drift" || test_type == "null_rate_drift" ||
+	       test_type == "distinct_count_drift" || test_type == "top_k_drift";
+}
+
+string DQCompiler::CompileDriftMetric(const string &test_type, const string &column_name,
+                                      const string &test_params_json) {
+	// The approx_* aggregates are sketch based (t-digest, HyperLogLog, space-saving), so every metric of a table
+	// is computed in one streaming pass
+	if (test_type == "mean_drift") {
+		return "avg(" + column_name + ")::DOUBLE";
+	} else if (test_type == "quantile_drift") {
+		// Expected format: {"quantile": 0.95, "max_change": 0.1}
+		string quantile = ExtractNumericParam(test_params_json, "quantile", "0.5");
+		return "approx_quantile(" + column_name + "::DOUBLE, " + quantile + ")";
+	} else if (test_type == "null_rate_drift") {
+		return "(COUNT(*) FILTER (WHERE " + column_name + " IS NULL))::DOUBLE / NULLIF(COUNT(*), 0)";
+	} else if (test_type == "distinct_count_drift") {
+		return "approx_count_distinct(" + column_name + ")::DOUBLE";
+	} else if (test_type == "top_k_drift") {
+		// Expected format: {"k": 10, "max_change": 0.2}
+		// The values are joined with the ASCII unit separator; DQDrift then counts each of them exactly
+		string k = ExtractNumericParam(test_params_json, "k", "10");
+		return "array_to_string(approx_top_k(" + column_name + ", " + k + ")::VARCHAR[], chr(31))";
+	}
+	throw InvalidInputException("Unknown drift test type: " + test_type);
+}
+
 string DQCompiler::SubstituteVariables(const string &sql, const string &table_name, const string &column_name) {
 	string result = sql;
 
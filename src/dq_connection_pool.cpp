@@ -0,0 +1,88 @@
+#include "dq_connection_pool.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/error_data.hpp"
+#include "duckdb/main/connection.hpp"
+
+namespace duckdb {
+
+DQPooledConnection::DQPooledConnection(DQConnectionPool &pool_p, unique_ptr<Connection> connection_p)
+    : pool(&pool_p), connection(std::move(connection_p)) {
+	if (connection) {
+		// DuckDB takes the snapshot when the transaction first reads a database, i.e. with the first query below
+		connection->Query("BEGIN TRANSACTION");
+	}
+}
+
+DQPooledConnection::~DQPooledConnection() {
+	if (!connection) {
+		return;
+	}
+	// The reader never writes, so a rollback ends the transaction like a commit, and also ends an aborted one
+	if (connection->Query("ROLLBACK")->HasError() || !pool->held_db) {
+		return;
+	}
+	lock_guard<mutex> guard(pool->reader_lock);
+	pool->idle_readers.push_back(std::move(connection));
+}
+
+unique_ptr<MaterializedQueryResult> DQPooledConnection::Query(const string &sql) {
+	if (!connection) {
+		return DQConnectionPool::ClosedResult();
+	}
+	return connection->Query(sql);
+}
+
+DQConnectionPool::DQConnectionPool(const weak_ptr<DatabaseInstance> &db, bool hold_database) : db(db) {
+	if (hold_database) {
+		held_db = db.lock();
+	}
+}
+
+unique_ptr<MaterializedQueryResult> DQConnectionPool::ClosedResult() {
+	return make_uniq<MaterializedQueryResult>(
+	    ErrorData(ExceptionType::CONNECTION, "The database was closed while the suite was running"));
+}
+
+unique_ptr<Connection> DQConnectionPool::OpenConnection() {
+	auto instance = db.lock();
+	if (!instance) {
+		return nullptr;
+	}
+	return make_uniq<Connection>(*instance);
+}
+
+bool DQConnectionPool::DatabaseClosed() const {
+	return db.expired();
+}
+
+DQPooledConnection DQConnectionPool::AcquireReader() {
+	unique_ptr<Connection> reader;
+	{
+		lock_guard<mutex> guard(reader_lock);
+		if (!idle_readers.empty()) {
+			reader = std::move(idle_readers.back());
+			idle_readers.pop_back();
+		}
+	}
+	if (!reader) {
+		reader = OpenConnection();
+	}
+	return DQPooledConnection(*this, std::move(reader));
+}
+
+unique_ptr<MaterializedQueryResult> DQConnectionPool::Write(const string &sql) {
+	lock_guard<mutex> guard(writer_lock);
+	if (held_db) {
+		if (!writer) {
+			writer = make_uniq<Connection>(*held_db);
+		}
+		return writer->Query(sql);
+	}
+	auto connection = OpenConnection();
+	if (!connection) {
+		return ClosedResult();
+	}
+	return connection->Query(sql);
+}
+
+} // namespace duckdb
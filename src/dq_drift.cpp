@@ -0,0 +1,368 @@
+#include "dq_drift.hpp"
+#include "dq_compiler.hpp"
+#include "dq_metrics.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/connection.hpp"
+#include <chrono>
+#include <cmath>
+#include <map>
+
+namespace duckdb {
+
+DQDrift::DriftProfile DQDrift::ReadProfile(const Value &metric) {
+	DriftProfile profile;
+	if (metric.IsNull()) {
+		return profile;
+	}
+	profile.is_null = false;
+	if (metric.type().id() == LogicalTypeId::VARCHAR) {
+		profile.text = metric.ToString();
+	} else {
+		profile.value = metric.GetValue<double>();
+	}
+	return profile;
+}
+
+double DQDrift::ComputeChange(const string &test_type, const DriftProfile &current, const DriftProfile &baseline) {
+	if (current.is_null || baseline.is_null) {
+		return current.is_null == baseline.is_null ? 0.0 : 1.0;
+	}
+
+	if (test_type == "top_k_drift") {
+		// A value outside one profile's top k counts with a share of 0 there
+		auto current_shares = ReadTopKShares(current);
+		auto baseline_shares = ReadTopKShares(baseline);
+		double distance = 0;
+		for (auto &entry : current_shares) {
+			auto baseline_entry = baseline_shares.find(entry.first);
+			auto baseline_share = baseline_entry == baseline_shares.end() ? 0.0 : baseline_entry->second;
+			distance += std::fabs(entry.second - baseline_share);
+		}
+		for (auto &entry : baseline_shares) {
+			if (current_shares.count(entry.first) == 0) {
+				distance += entry.second;
+			}
+		}
+		return distance / 2;
+	}
+
+	if (test_type == "null_rate_drift") {
+		return std::fabs(current.value - baseline.value);
+	}
+
+	if (baseline.value == 0) {
+		return current.value == 0 ? 0.0 : 1.0;
+	}
+	return std::fabs(current.value - baseline.value) / std::fabs(baseline.value);
+}
+
+unordered_map<string, double> DQDrift::ReadTopKShares(const DriftProfile &profile) {
+	unordered_map<string, double> shares;
+	if (profile.rows_total <= 0) {
+		return shares;
+	}
+	for (auto &pair : StringUtil::Split(profile.text, '\x1f')) {
+		auto separator = pair.rfind('\x1e');
+		if (separator == string::npos) {
+			continue;
+		}
+		auto count = std::stod(pair.substr(separator + 1));
+		shares[pair.substr(0, separator)] = count / static_cast<double>(profile.rows_total);
+	}
+	return shares;
+}
+
+string DQDrift::CountTopKValues(DQPooledConnection &con, const vector<DQTestDefinition> &tests,
+                                const vector<idx_t> &table_tests, const string &table_name, int64_t rows_total,
+                                vector<Value> &metrics) {
+	string count_sql;
+	vector<vector<string>> top_values(table_tests.size());
+	for (idx_t i = 0; i < table_tests.size(); i++) {
+		auto &test = tests[table_tests[i]];
+		if (test.test_type != "top_k_drift" || metrics[i].IsNull()) {
+			continue;
+		}
+		top_values[i] = StringUtil::Split(metrics[i].ToString(), '\x1f');
+		for (auto &value : top_values[i]) {
+			count_sql += count_sql.empty() ? "SELECT " : ", ";
+			count_sql += "COUNT(*) FILTER (WHERE " + test.column_name + "::VARCHAR = " + Value(value).ToSQLString() + ")";
+		}
+	}
+	if (count_sql.empty()) {
+		return string();
+	}
+
+	auto count_result = con.Query(count_sql + " FROM " + table_name);
+	if (count_result->HasError()) {
+		return "Error counting top values: " + count_result->GetError();
+	}
+	auto chunk = count_result->Fetch();
+	if (!chunk || chunk->size() == 0) {
+		return "Counting top values returned no rows";
+	}
+	DQMetrics::Get().RecordRowsScanned(rows_total);
+
+	idx_t column = 0;
+	for (idx_t i = 0; i < table_tests.size(); i++) {
+		if (top_values[i].empty()) {
+			continue;
+		}
+		string pairs;
+		for (auto &value : top_values[i]) {
+			if (!pairs.empty()) {
+				pairs += '\x1f';
+			}
+			pairs += value + '\x1e' + chunk->GetValue(column++, 0).ToString();
+		}
+		metrics[i] = Value(pairs);
+	}
+	return string();
+}
+
+unordered_map<idx_t, DQTestResult> DQDrift::ExecuteDriftTests(DQConnectionPool &pool,
+                                                              const vector<DQTestDefinition> &tests,
+                                                              const vector<idx_t> &test_indexes,
+                                                              const string &execution_id) {
+	unordered_map<idx_t, DQTestResult> results;
+
+	// One profile scan per table, covering all drift tests on it
+	std::map<string, vector<idx_t>> tests_by_table;
+	for (auto i : test_indexes) {
+		// Drift with group_by is not supported; those tests report it through the segmented path
+		if (DQCompiler::IsDriftTest(tests[i].test_type) && tests[i].group_by.empty()) {
+			tests_by_table[tests[i].table_name].push_back(i);
+		}
+	}
+	if (tests_by_table.empty()) {
+		return results;
+	}
+
+	// Load the latest passing profile of every drift test
+	string id_list;
+	for (auto &entry : tests_by_table) {
+		for (auto idx : entry.second) {
+			if (!id_list.empty()) {
+				id_list += ", ";
+			}
+			id_list += Value(tests[idx].test_id).ToSQLString();
+		}
+	}
+	unordered_map<string, DriftProfile> baselines;
+	{
+		auto con = pool.AcquireReader();
+		auto baseline_result = con.Query(
+		    "SELECT test_id, metric_value, metric_text, rows_total FROM dq_test_profiles WHERE (status = 'pass' OR "
+		    "accepted) AND test_id IN (" +
+		    id_list + ") QUALIFY ROW_NUMBER() OVER (PARTITION BY test_id ORDER BY profiled_at DESC) = 1");
+		if (!baseline_result->HasError()) {
+			while (true) {
+				auto chunk = baseline_result->Fetch();
+				if (!chunk || chunk->size() == 0) {
+					break;
+				}
+				for (idx_t i = 0; i < chunk->size(); i++) {
+					auto metric_text = chunk->GetValue(2, i);
+					auto baseline = ReadProfile(metric_text.IsNull() ? chunk->GetValue(1, i) : metric_text);
+					auto baseline_rows = chunk->GetValue(3, i);
+					baseline.rows_total = baseline_rows.IsNull() ? 0 : baseline_rows.GetValue<int64_t>();
+					baselines[chunk->GetValue(0, i).ToString()] = baseline;
+				}
+			}
+		}
+	}
+
+	for (auto &entry : tests_by_table) {
+		auto &table_name = entry.first;
+		auto &table_tests = entry.second;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// The profile and the exact top-k counts are read in one transaction
+		string error_message;
+		unique_ptr<DataChunk> chunk;
+		int64_t rows_total = 0;
+		vector<Value> metrics;
+		string top_k_error;
+		{
+			auto con = pool.AcquireReader();
+			try {
+				string profile_sql = "SELECT COUNT(*)";
+				for (auto idx : table_tests) {
+					auto &test = tests[idx];
+					profile_sql +=
+					    ", " + DQCompiler::CompileDriftMetric(test.test_type, test.column_name, test.test_params);
+				}
+				profile_sql += " FROM " + table_name;
+
+				auto profile_result = con.Query(profile_sql);
+				if (profile_result->HasError()) {
+					error_message = profile_result->GetError();
+				} else {
+					chunk = profile_result->Fetch();
+				}
+			} catch (std::exception &e) {
+				error_message = string("Exception during test execution: ") + e.what();
+			}
+
+			// approx_top_k only names the most frequent values; top_k_drift compares their exact frequency shares
+			if (chunk && chunk->size() > 0) {
+				rows_total = chunk->GetValue(0, 0).GetValue<int64_t>();
+				DQMetrics::Get().RecordRowsScanned(rows_total);
+				for (idx_t i = 0; i < table_tests.size(); i++) {
+					metrics.push_back(chunk->GetValue(i + 1, 0));
+				}
+				top_k_error = CountTopKValues(con, tests, table_tests, table_name, rows_total, metrics);
+			}
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+		auto per_test_ms = elapsed_ms / static_cast<int64_t>(table_tests.size());
+
+		if (!chunk || chunk->size() == 0) {
+			for (auto idx : table_tests) {
+				auto result = DQExecutor::ResolveTest(tests[idx], 0, 0, per_test_ms);
+				result.status = "fail";
+				result.error_message = error_message.empty() ? "Profile scan returned no rows" : error_message;
+				results[idx] = result;
+			}
+			continue;
+		}
+
+		for (idx_t i = 0; i < table_tests.size(); i++) {
+			auto idx = table_tests[i];
+			auto &test = tests[idx];
+			auto &metric = metrics[i];
+			auto current = ReadProfile(metric);
+			current.rows_total = rows_total;
+
+			// Without a baseline the first profile becomes the baseline and the test passes
+			int64_t rows_failed = 0;
+			string drift_error;
+			auto baseline_entry = baselines.find(test.test_id);
+			if (baseline_entry != baselines.end()) {
+				try {
+					double max_change =
+					    std::stod(DQCompiler::ExtractNumericParam(test.test_params, "max_change", "0.1"));
+					if (ComputeChange(test.test_type, current, baseline_entry->second) > max_change) {
+						rows_failed = 1;
+					}
+				} catch (std::exception &e) {
+					drift_error = string("Invalid max_change for drift test: ") + e.what();
+				}
+			}
+			if (test.test_type == "top_k_drift" && !top_k_error.empty()) {
+				drift_error = top_k_error;
+			}
+
+			auto result = DQExecutor::ResolveTest(test, rows_failed, rows_total, per_test_ms);
+			if (!drift_error.empty()) {
+				result.status = "fail";
+				result.error_message = drift_error;
+			}
+			results[idx] = result;
+
+			string insert_sql = "INSERT INTO dq_test_profiles (test_id, execution_id, status, rows_total, metric_value, "
+			                    "metric_text) VALUES (" +
+			                    Value(test.test_id).ToSQLString() + ", " + Value(execution_id).ToSQLString() + ", " +
+			                    Value(result.status).ToSQLString() + ", " + std::to_string(rows_total) + ", ";
+			if (current.is_null) {
+				insert_sql += "NULL, NULL)";
+			} else if (metric.type().id() == LogicalTypeId::VARCHAR) {
+				insert_sql += "NULL, " + Value(current.text).ToSQLString() + ")";
+			} else {
+				insert_sql += Value::DOUBLE(current.value).ToSQLString() + ", NULL)";
+			}
+			pool.Write(insert_sql);
+		}
+	}
+
+	return results;
+}
+
+struct AcceptDriftBindData : public FunctionData {
+	string test_id;
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto result = make_uniq<AcceptDriftBindData>();
+		result->test_id = test_id;
+		return result;
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		return test_id == other_p.Cast<AcceptDriftBindData>().test_id;
+	}
+};
+
+struct AcceptDriftGlobalState : public GlobalTableFunctionState {
+	string status;
+	bool finished = false;
+
+	idx_t MaxThreads() const override {
+		return 1;
+	}
+};
+
+static unique_ptr<FunctionData> AcceptDriftBind(ClientContext &context, TableFunctionBindInput &input,
+                                                vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs[0].IsNull()) {
+		throw InvalidInputException("dq_accept_drift: test_id cannot be NULL");
+	}
+	auto bind_data = make_uniq<AcceptDriftBindData>();
+	bind_data->test_id = StringValue::Get(input.inputs[0]);
+
+	names.push_back("status");
+	return_types.push_back(LogicalType::VARCHAR);
+
+	return bind_data;
+}
+
+//! Makes the test's latest profile its baseline, so drift is measured from the accepted level on
+static unique_ptr<GlobalTableFunctionState> AcceptDriftGlobalInit(ClientContext &context,
+                                                                  TableFunctionInitInput &input) {
+	auto state = make_uniq<AcceptDriftGlobalState>();
+	auto &bind_data = input.bind_data->Cast<AcceptDriftBindData>();
+
+	Connection con(DatabaseInstance::GetDatabase(context));
+	auto test_literal = Value(bind_data.test_id).ToSQLString();
+	auto latest = con.Query("SELECT profile_id FROM dq_test_profiles WHERE test_id = " + test_literal +
+	                        " ORDER BY profiled_at DESC LIMIT 1");
+	if (latest->HasError()) {
+		throw InvalidInputException("Error reading profiles: " + latest->GetError());
+	}
+	auto chunk = latest->Fetch();
+	if (!chunk || chunk->size() == 0) {
+		throw InvalidInputException("dq_accept_drift: no drift profile for test_id '" + bind_data.test_id + "'");
+	}
+	auto profile_id = chunk->GetValue(0, 0).ToString();
+
+	auto update = con.Query("UPDATE dq_test_profiles SET accepted = true WHERE profile_id = " +
+	                        Value(profile_id).ToSQLString());
+	if (update->HasError()) {
+		throw InvalidInputException("Error accepting profile: " + update->GetError());
+	}
+	state->status = "ACCEPTED: " + profile_id;
+	return state;
+}
+
+static void AcceptDriftFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<AcceptDriftGlobalState>();
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(global_state.status));
+	global_state.finished = true;
+}
+
+void RegisterDQDriftFunctions(ExtensionLoader &loader) {
+	TableFunction accept_func("dq_accept_drift", {LogicalType::VARCHAR}, AcceptDriftFunc, AcceptDriftBind,
+	                          AcceptDriftGlobalInit);
+	loader.RegisterFunction(accept_func);
+}
+
+} // namespace duckdb
@@ -1,37 +1,553 @@
 #include "dq_executor.hpp"
 #include "dq_compiler.hpp"
+#include "dq_optimizer.hpp"
+#include "dq_planner.hpp"
+#include "dq_drift.hpp"
+#include "dq_connection_pool.hpp"
+#include "dq_materializer.hpp"
+#include "dq_metrics.hpp"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/main/connection.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
 
 namespace duckdb {
 
-DQTestResult DQExecutor::ExecuteTest(ClientContext &context, const string &test_id, const string &test_name,
-                                     const string &table_name, const string &column_name, const string &test_type,
-                                     const string &test_params_json, const string &severity, const string &warn_if,
-                                     const string &error_if) {
+static DQTestResult InitResult(const DQTestDefinition &test) {
 	DQTestResult result;
-	result.test_id = test_id;
-	result.test_name = test_name;
-	result.table_name = table_name;
-	result.column_name = column_name;
-	result.test_type = test_type;
-	result.severity = severity;
+	result.test_id = test.test_id;
+	result.test_name = test.test_name;
+	result.table_name = test.table_name;
+	result.column_name = test.column_name;
+	result.test_type = test.test_type;
+	result.severity = test.severity;
 	result.rows_failed = 0;
 	result.rows_total = 0;
+	result.execution_time_ms = 0;
+	result.estimated_rows = -1;
+	return result;
+}
+
+vector<DQTestDefinition> DQExecutor::LoadTests(Connection &con, const DQTestFilter &filter) {
+	// Build query to fetch tests
+	string query = "SELECT test_id, test_name, table_name, column_name, test_type, test_params, severity, warn_if, "
+	               "error_if, depends_on, group_by FROM dq_tests WHERE enabled = true";
+
+	if (!filter.test_id.empty()) {
+		query += " AND test_id = '" + filter.test_id + "'";
+	} else {
+		if (!filter.table_name.empty()) {
+			query += " AND table_name = '" + filter.table_name + "'";
+		}
+		if (!filter.tag.empty()) {
+			query += " AND '" + filter.tag + "' = ANY(tags)";
+		}
+	}
+
+	auto result = con.Query(query);
+
+	if (result->HasError()) {
+		throw InvalidInputException("Error fetching tests: " + result->GetError());
+	}
+
+	vector<DQTestDefinition> tests;
+	while (true) {
+		auto chunk = result->Fetch();
+		if (!chunk || chunk->size() == 0) {
+			break;
+		}
+
+		for (idx_t i = 0; i < chunk->size(); i++) {
+			DQTestDefinition test;
+			test.test_id = chunk->GetValue(0, i).ToString();
+			test.test_name = chunk->GetValue(1, i).ToString();
+			test.table_name = chunk->GetValue(2, i).ToString();
+			test.column_name = chunk->GetValue(3, i).IsNull() ? "" : chunk->GetValue(3, i).ToString();
+			test.test_type = chunk->GetValue(4, i).ToString();
+			test.test_params = chunk->GetValue(5, i).IsNull() ? "{}" : chunk->GetValue(5, i).ToString();
+			test.severity = chunk->GetValue(6, i).ToString();
+			test.warn_if = chunk->GetValue(7, i).IsNull() ? "" : chunk->GetValue(7, i).ToString();
+			test.error_if = chunk->GetValue(8, i).IsNull() ? "" : chunk->GetValue(8, i).ToString();
+			auto depends_on = chunk->GetValue(9, i);
+			if (!depends_on.IsNull()) {
+				for (auto &dependency : ListValue::GetChildren(depends_on)) {
+					if (!dependency.IsNull()) {
+						test.depends_on.push_back(dependency.ToString());
+					}
+				}
+			}
+			test.group_by = chunk->GetValue(10, i).IsNull() ? "" : chunk->GetValue(10, i).ToString();
+			tests.push_back(std::move(test));
+		}
+	}
+	return tests;
+}
+
+string DQExecutor::GenerateExecutionId(Connection &con) {
+	// Generate execution ID for this batch using SQL
+	auto uuid_result = con.Query("SELECT gen_random_uuid()::VARCHAR");
+	if (!uuid_result->HasError()) {
+		auto uuid_chunk = uuid_result->Fetch();
+		if (uuid_chunk && uuid_chunk->size() > 0) {
+			return uuid_chunk->GetValue(0, 0).ToString();
+		}
+	}
+	// Fallback to timestamp-based ID if UUID generation fails
+	return std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+}
+
+vector<vector<idx_t>> DQExecutor::ResolveDependencies(const vector<DQTestDefinition> &tests) {
+	unordered_map<string, idx_t> by_key;
+	unordered_map<string, vector<idx_t>> row_count_tests;
+	unordered_map<string, vector<idx_t>> key_tests; // unique/not_null tests by "table.column"
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto &test = tests[i];
+		by_key[test.test_name] = i;
+		by_key[test.test_id] = i;
+		if (test.test_type == "row_count") {
+			row_count_tests[test.table_name].push_back(i);
+		} else if (test.test_type == "unique" || test.test_type == "not_null") {
+			key_tests[test.table_name + "." + test.column_name].push_back(i);
+		}
+	}
+
+	vector<vector<idx_t>> dependencies(tests.size());
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto &test = tests[i];
+		auto &deps = dependencies[i];
+		auto add_dependency = [&](idx_t dep) {
+			if (dep != i && std::find(deps.begin(), deps.end(), dep) == deps.end()) {
+				deps.push_back(dep);
+			}
+		};
+
+		// Prerequisites outside of this run are ignored
+		for (auto &name : test.depends_on) {
+			auto entry = by_key.find(name);
+			if (entry != by_key.end()) {
+				add_dependency(entry->second);
+			}
+		}
+
+		if (test.test_type == "relationship") {
+			auto to_table = DQCompiler::ExtractStringParam(test.test_params, "to_table");
+			auto to_column = DQCompiler::ExtractStringParam(test.test_params, "to_column");
+			auto entry = key_tests.find(to_table + "." + to_column);
+			if (entry != key_tests.end()) {
+				for (auto dep : entry->second) {
+					add_dependency(dep);
+				}
+			}
+		}
+
+		if (test.test_type != "row_count") {
+			auto entry = row_count_tests.find(test.table_name);
+			if (entry != row_count_tests.end()) {
+				for (auto dep : entry->second) {
+					add_dependency(dep);
+				}
+			}
+		}
+	}
+	return dependencies;
+}
+
+static uint64_t ElapsedMicros(std::chrono::steady_clock::time_point start) {
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+//! Shared scans and drift profiles of a run. Each one runs when the first of its tests is about to run, so it only
+//! happens once the prerequisites of its tests have passed.
+class DQSharedWork {
+public:
+	DQSharedWork(DQConnectionPool &pool, const vector<DQTestDefinition> &tests, const vector<DQTestPlan> &plans,
+	             const vector<idx_t> &depths, const string &execution_id)
+	    : pool(pool), tests(tests), execution_id(execution_id), scan_of_test(tests.size(), DConstants::INVALID_INDEX),
+	      drift_of_test(tests.size(), DConstants::INVALID_INDEX) {
+		scans = DQOptimizer::PlanSharedScans(tests, plans, depths);
+		for (idx_t scan_idx = 0; scan_idx < scans.size(); scan_idx++) {
+			for (auto test_idx : scans[scan_idx].test_indexes) {
+				scan_of_test[test_idx] = scan_idx;
+			}
+			scan_steps.push_back(make_uniq<Step>());
+		}
+
+		// Drift tests are profiled in one pass per table and DAG depth
+		std::map<std::pair<idx_t, string>, vector<idx_t>> drift_by_table;
+		for (idx_t i = 0; i < tests.size(); i++) {
+			if (DQCompiler::IsDriftTest(tests[i].test_type) && tests[i].group_by.empty() &&
+			    depths[i] != DConstants::INVALID_INDEX) {
+				drift_by_table[std::make_pair(depths[i], tests[i].table_name)].push_back(i);
+			}
+		}
+		for (auto &entry : drift_by_table) {
+			for (auto test_idx : entry.second) {
+				drift_of_test[test_idx] = drift_groups.size();
+			}
+			drift_groups.push_back(entry.second);
+			drift_steps.push_back(make_uniq<Step>());
+		}
+	}
+
+	//! Runs the shared scan and drift profile covering the test, unless they already ran
+	void Prepare(idx_t test_idx) {
+		auto scan_idx = scan_of_test[test_idx];
+		if (scan_idx != DConstants::INVALID_INDEX) {
+			lock_guard<mutex> guard(scan_steps[scan_idx]->lock);
+			if (!scan_steps[scan_idx]->done) {
+				DQSharedScanResults scan_results;
+				DQOptimizer::ExecuteSharedScan(pool, scans[scan_idx], scan_results);
+				lock_guard<mutex> results_guard(results_lock);
+				for (auto &entry : scan_results.tests) {
+					shared.tests[entry.first] = entry.second;
+				}
+				scan_steps[scan_idx]->done = true;
+			}
+		}
+		auto drift_idx = drift_of_test[test_idx];
+		if (drift_idx != DConstants::INVALID_INDEX) {
+			lock_guard<mutex> guard(drift_steps[drift_idx]->lock);
+			if (!drift_steps[drift_idx]->done) {
+				auto drift_results = DQDrift::ExecuteDriftTests(pool, tests, drift_groups[drift_idx], execution_id);
+				lock_guard<mutex> results_guard(results_lock);
+				for (auto &entry : drift_results) {
+					drift[entry.first] = std::move(entry.second);
+				}
+				drift_steps[drift_idx]->done = true;
+			}
+		}
+	}
+
+	bool FindDriftResult(idx_t test_idx, DQTestResult &result) {
+		lock_guard<mutex> guard(results_lock);
+		auto entry = drift.find(test_idx);
+		if (entry == drift.end()) {
+			return false;
+		}
+		result = entry->second;
+		return true;
+	}
+
+	bool FindSharedCounts(idx_t test_idx, DQSharedCounts &counts) {
+		lock_guard<mutex> guard(results_lock);
+		auto entry = shared.tests.find(test_idx);
+		if (entry == shared.tests.end()) {
+			return false;
+		}
+		counts = entry->second;
+		return true;
+	}
+
+private:
+	struct Step {
+		mutex lock;
+		bool done = false;
+	};
+
+	DQConnectionPool &pool;
+	const vector<DQTestDefinition> &tests;
+	const string &execution_id;
+
+	vector<DQOptimizer::SharedScan> scans;
+	vector<idx_t> scan_of_test;
+	vector<unique_ptr<Step>> scan_steps;
+	vector<vector<idx_t>> drift_groups;
+	vector<idx_t> drift_of_test;
+	vector<unique_ptr<Step>> drift_steps;
+
+	mutex results_lock;
+	DQSharedScanResults shared;
+	unordered_map<idx_t, DQTestResult> drift;
+};
+
+static DQTestResult RunPlannedTest(DQConnectionPool &pool, const DQTestDefinition &test, idx_t test_idx,
+                                   const DQTestPlan &plan, DQSharedWork &shared_work) {
+	auto &metrics = DQMetrics::Get();
+	shared_work.Prepare(test_idx);
+
+	DQTestResult drift_result;
+	if (shared_work.FindDriftResult(test_idx, drift_result)) {
+		metrics.RecordSharedScan(true);
+		drift_result.strategy = "profile";
+		return drift_result;
+	}
+	if (!test.group_by.empty()) {
+		metrics.RecordSharedScan(false);
+		return DQExecutor::ExecuteSegmentedTest(pool, test);
+	}
+	if (plan.strategy != "exact") {
+		return DQPlanner::ExecutePlannedTest(pool, test, plan);
+	}
+	DQSharedCounts counts;
+	if (shared_work.FindSharedCounts(test_idx, counts)) {
+		metrics.RecordSharedScan(true);
+		auto result = DQExecutor::ResolveTest(test, counts.rows_failed, counts.rows_total, counts.execution_time_ms);
+		result.strategy = "shared_scan";
+		return result;
+	}
+	metrics.RecordSharedScan(false);
+	return DQExecutor::ExecuteTest(pool, test);
+}
+
+//! Whether a test that never became ready lies on a dependency cycle, rather than only depending on one
+static bool OnDependencyCycle(idx_t start, const vector<vector<idx_t>> &dependencies,
+                              const vector<DQTestResult> &results) {
+	vector<bool> visited(dependencies.size(), false);
+	vector<idx_t> stack = dependencies[start];
+	while (!stack.empty()) {
+		auto current = stack.back();
+		stack.pop_back();
+		if (current == start) {
+			return true;
+		}
+		if (visited[current] || !results[current].status.empty()) {
+			continue;
+		}
+		visited[current] = true;
+		for (auto dep : dependencies[current]) {
+			stack.push_back(dep);
+		}
+	}
+	return false;
+}
+
+vector<DQTestResult> DQExecutor::RunSuite(const weak_ptr<DatabaseInstance> &db,
+                                          const vector<DQTestDefinition> &suite_tests, const string &execution_id,
+                                          optional_ptr<DQRunProgress> progress, const DQRunOptions &options) {
+	auto &metrics = DQMetrics::Get();
+	auto run_start = std::chrono::steady_clock::now();
+	if (progress) {
+		progress->tests_total = suite_tests.size();
+	}
+	DQConnectionPool pool(db, options.hold_database);
+	auto cancelled = [&]() {
+		return (progress && progress->cancel_requested) || pool.DatabaseClosed();
+	};
+	idx_t max_threads = 1;
+	{
+		auto instance = db.lock();
+		if (!instance) {
+			return vector<DQTestResult>();
+		}
+		max_threads = MaxValue<idx_t>(1, static_cast<idx_t>(TaskScheduler::GetScheduler(*instance).NumberOfThreads()));
+	}
+
+	// Dependencies are resolved on the original names, before tests are pointed at materialized views
+	auto dependencies = ResolveDependencies(suite_tests);
+
+	// Views are copied once, before any test runs
+	unique_ptr<DQViewMaterializer> materializer;
+	vector<DQTestDefinition> materialized_tests;
+	if (options.materialize_views) {
+		materializer = make_uniq<DQViewMaterializer>(pool, execution_id);
+		materialized_tests = materializer->Materialize(suite_tests);
+	}
+	auto &tests = materializer ? materialized_tests : suite_tests;
+
+	vector<idx_t> pending(tests.size());
+	vector<vector<idx_t>> dependents(tests.size());
+	for (idx_t i = 0; i < tests.size(); i++) {
+		pending[i] = dependencies[i].size();
+		for (auto dep : dependencies[i]) {
+			dependents[dep].push_back(i);
+		}
+	}
+
+	// Depth of each test in the DAG; tests on or behind a dependency cycle never get one
+	vector<idx_t> depths(tests.size(), DConstants::INVALID_INDEX);
+	{
+		auto remaining = pending;
+		vector<idx_t> depth(tests.size(), 0);
+		vector<idx_t> queue;
+		for (idx_t i = 0; i < tests.size(); i++) {
+			if (remaining[i] == 0) {
+				queue.push_back(i);
+			}
+		}
+		while (!queue.empty()) {
+			auto test_idx = queue.back();
+			queue.pop_back();
+			depths[test_idx] = depth[test_idx];
+			for (auto dependent : dependents[test_idx]) {
+				depth[dependent] = MaxValue<idx_t>(depth[dependent], depth[test_idx] + 1);
+				if (--remaining[dependent] == 0) {
+					queue.push_back(dependent);
+				}
+			}
+		}
+	}
+
+	// Pick each test's strategy from the catalog's estimates and statistics before anything is scanned
+	auto plans = DQPlanner::PlanTests(pool, tests, options);
+	DQSharedWork shared_work(pool, tests, plans, depths, execution_id);
+
+	// A test without status has not produced a result yet
+	vector<DQTestResult> results(tests.size());
+	auto finish_test = [&](idx_t test_idx, DQTestResult result) {
+		if (materializer) {
+			materializer->RestoreNames(result);
+		}
+		// Store result in database right away so an interrupted run keeps its completed work
+		auto store_start = std::chrono::steady_clock::now();
+		StoreResult(pool, result, execution_id);
+		metrics.RecordStore(ElapsedMicros(store_start));
+		metrics.RecordTest(result.test_type, result.status, result.execution_time_ms);
+		results[test_idx] = std::move(result);
+		if (progress) {
+			progress->tests_done++;
+		}
+	};
+
+	auto run_test = [&](idx_t test_idx) {
+		string failed_prerequisite;
+		for (auto dep : dependencies[test_idx]) {
+			if (results[dep].status == "fail" || results[dep].status == "skipped") {
+				failed_prerequisite = tests[dep].test_name;
+				break;
+			}
+		}
+		if (!failed_prerequisite.empty()) {
+			auto result = InitResult(tests[test_idx]);
+			result.status = "skipped";
+			result.error_message = "Skipped: prerequisite '" + failed_prerequisite + "' did not pass";
+			finish_test(test_idx, std::move(result));
+			return;
+		}
+
+		DQTestResult result;
+		try {
+			result = RunPlannedTest(pool, tests[test_idx], test_idx, plans[test_idx], shared_work);
+		} catch (std::exception &e) {
+			result = InitResult(tests[test_idx]);
+			result.status = "fail";
+			result.error_message = string("Exception during test execution: ") + e.what();
+		}
+		if (result.strategy.empty()) {
+			result.strategy = "exact";
+		}
+		result.estimated_rows = plans[test_idx].estimated_rows;
+		finish_test(test_idx, std::move(result));
+	};
+
+	// A test is queued as soon as its own prerequisites have a result, so a slow test only holds back its dependents
+	mutex queue_lock;
+	std::condition_variable queue_changed;
+	std::deque<std::pair<idx_t, std::chrono::steady_clock::time_point>> ready;
+	idx_t in_flight = 0;
+	auto run_ready_at = std::chrono::steady_clock::now();
+	for (idx_t i = 0; i < tests.size(); i++) {
+		if (pending[i] == 0) {
+			ready.emplace_back(i, run_ready_at);
+		}
+	}
+
+	auto worker = [&]() {
+		unique_lock<mutex> guard(queue_lock);
+		while (true) {
+			queue_changed.wait(guard, [&]() { return !ready.empty() || in_flight == 0 || cancelled(); });
+			if (cancelled() || ready.empty()) {
+				break;
+			}
+			auto entry = ready.front();
+			ready.pop_front();
+			in_flight++;
+			guard.unlock();
+
+			metrics.RecordQueueWait(ElapsedMicros(entry.second));
+			run_test(entry.first);
+
+			guard.lock();
+			in_flight--;
+			auto ready_at = std::chrono::steady_clock::now();
+			for (auto dependent : dependents[entry.first]) {
+				if (--pending[dependent] == 0) {
+					ready.emplace_back(dependent, ready_at);
+				}
+			}
+			queue_changed.notify_all();
+		}
+		// Let the other workers see that the queue drained or the run was cancelled
+		queue_changed.notify_all();
+	};
+	idx_t thread_count = MinValue<idx_t>(max_threads, MaxValue<idx_t>(1, tests.size()));
+	vector<std::thread> threads;
+	for (idx_t t = 1; t < thread_count; t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	// Tests that never became ready lie on a dependency cycle, or depend on a test that does
+	if (!cancelled()) {
+		vector<DQTestResult> unreached;
+		vector<idx_t> unreached_indexes;
+		for (idx_t i = 0; i < tests.size(); i++) {
+			if (!results[i].status.empty()) {
+				continue;
+			}
+			auto result = InitResult(tests[i]);
+			if (OnDependencyCycle(i, dependencies, results)) {
+				result.status = "fail";
+				result.error_message = "Dependency cycle: test '" + tests[i].test_name + "' can never run";
+			} else {
+				string blocked_by;
+				for (auto dep : dependencies[i]) {
+					if (results[dep].status.empty()) {
+						blocked_by = tests[dep].test_name;
+						break;
+					}
+				}
+				result.status = "skipped";
+				result.error_message = "Skipped: prerequisite '" + blocked_by + "' depends on a dependency cycle";
+			}
+			unreached.push_back(std::move(result));
+			unreached_indexes.push_back(i);
+		}
+		for (idx_t i = 0; i < unreached.size(); i++) {
+			finish_test(unreached_indexes[i], std::move(unreached[i]));
+		}
+	}
+
+	vector<DQTestResult> completed;
+	for (auto &result : results) {
+		if (!result.status.empty()) {
+			completed.push_back(std::move(result));
+		}
+	}
+
+	metrics.RecordRun(ElapsedMicros(run_start));
+	auto instance = db.lock();
+	if (instance && !options.metrics_path.empty()) {
+		metrics.TryDumpPrometheus(*instance, options.metrics_path);
+	}
+	return completed;
+}
+
+DQTestResult DQExecutor::ExecuteTest(DQConnectionPool &pool, const DQTestDefinition &test) {
+	auto result = InitResult(test);
+	auto &table_name = test.table_name;
 
 	auto start = std::chrono::high_resolution_clock::now();
 
+	// Count and test query run in one transaction, so they can't disagree
+	auto con = pool.AcquireReader();
+
 	try {
 		// Compile the test to SQL
-		result.compiled_sql = DQCompiler::CompileTest(test_type, table_name, column_name, test_params_json);
+		result.compiled_sql =
+		    DQCompiler::CompileTest(test.test_type, test.table_name, test.column_name, test.test_params);
 
 		// printf("Compiled SQL for test '%s': %s\n", test_name.c_str(), result.compiled_sql.c_str());
 
-		// Execute the query
-		Connection con(context.db->GetDatabase(context));
-
 		// First, get the total row count of the table
 		auto count_query = "SELECT COUNT(*) FROM " + table_name;
 		auto count_result = con.Query(count_query);
@@ -64,9 +580,11 @@ DQTestResult DQExecutor::ExecuteTest(ClientContext &context, const string &test_
 			}
 
 			result.rows_failed = static_cast<int64_t>(failed_count);
+			DQMetrics::Get().RecordRowsScanned(result.rows_total);
 
 			// Determine status based on thresholds
-			result.status = DetermineStatus(result.rows_failed, result.rows_total, severity, warn_if, error_if);
+			result.status =
+			    DetermineStatus(result.rows_failed, result.rows_total, test.severity, test.warn_if, test.error_if);
 		}
 
 	} catch (std::exception &e) {
@@ -80,6 +598,77 @@ DQTestResult DQExecutor::ExecuteTest(ClientContext &context, const string &test_
 	return result;
 }
 
+DQTestResult DQExecutor::ExecuteSegmentedTest(DQConnectionPool &pool, const DQTestDefinition &test) {
+	auto result = InitResult(test);
+	result.status = "pass";
+
+	auto start = std::chrono::high_resolution_clock::now();
+	auto con = pool.AcquireReader();
+
+	try {
+		result.compiled_sql = DQCompiler::CompileSegmentedTest(test.test_type, test.table_name, test.column_name,
+		                                                       test.test_params, test.group_by);
+
+		auto segment_result = con.Query(result.compiled_sql);
+		if (segment_result->HasError()) {
+			result.error_message = segment_result->GetError();
+			result.status = "fail";
+		} else {
+			while (true) {
+				auto chunk = segment_result->Fetch();
+				if (!chunk || chunk->size() == 0) {
+					break;
+				}
+				for (idx_t i = 0; i < chunk->size(); i++) {
+					DQSegmentResult segment;
+					segment.segment = chunk->GetValue(0, i).ToString();
+					segment.rows_failed = chunk->GetValue(1, i).GetValue<int64_t>();
+					segment.rows_total = chunk->GetValue(2, i).GetValue<int64_t>();
+					// Thresholds apply to each segment on its own, so a percentage is relative to the segment
+					segment.status = DetermineStatus(segment.rows_failed, segment.rows_total, test.severity,
+					                                 test.warn_if, test.error_if);
+
+					result.rows_failed += segment.rows_failed;
+					result.rows_total += segment.rows_total;
+					if (segment.status == "fail" || (segment.status == "warn" && result.status == "pass")) {
+						result.status = segment.status;
+					}
+					result.segments.push_back(std::move(segment));
+				}
+			}
+			DQMetrics::Get().RecordRowsScanned(result.rows_total);
+		}
+	} catch (std::exception &e) {
+		result.error_message = string("Exception during test execution: ") + e.what();
+		result.status = "fail";
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	result.execution_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+	return result;
+}
+
+DQTestResult DQExecutor::ResolveTest(const DQTestDefinition &test, int64_t rows_failed, int64_t rows_total,
+                                     int64_t execution_time_ms) {
+	auto result = InitResult(test);
+	result.execution_time_ms = execution_time_ms;
+
+	try {
+		// Keep the row-returning SQL so failing rows can still be inspected by hand
+		result.compiled_sql =
+		    DQCompiler::CompileTest(test.test_type, test.table_name, test.column_name, test.test_params);
+		result.rows_failed = rows_failed;
+		result.rows_total = rows_total;
+		result.status = DetermineStatus(rows_failed, rows_total, test.severity, test.warn_if, test.error_if);
+	} catch (std::exception &e) {
+		result.error_message = string("Exception during test execution: ") + e.what();
+		result.status = "fail";
+	}
+
+	return result;
+}
+
 string DQExecutor::DetermineStatus(int64_t rows_failed, int64_t rows_total, const string &severity,
                                    const string &warn_if, const string &error_if) {
 	if (rows_failed == 0) {
@@ -168,11 +757,9 @@ bool DQExecutor::EvaluateThreshold(const string &threshold, int64_t rows_failed,
 	return false;
 }
 
-void DQExecutor::StoreResult(ClientContext &context, const DQTestResult &result, const string &execution_id) {
-	Connection con(context.db->GetDatabase(context));
-
+void DQExecutor::StoreResult(DQConnectionPool &pool, const DQTestResult &result, const string &execution_id) {
 	string insert_sql = "INSERT INTO dq_test_results (test_id, execution_id, status, rows_failed, rows_total, "
-	                    "compiled_sql, error_message, execution_time_ms) VALUES ('" +
+	                    "compiled_sql, error_message, execution_time_ms, strategy, estimated_rows) VALUES ('" +
 	                    result.test_id + "', '" + execution_id + "', '" + result.status + "', " +
 	                    std::to_string(result.rows_failed) + ", " + std::to_string(result.rows_total) + ", $$" +
 	                    result.compiled_sql + "$$, ";
@@ -190,10 +777,30 @@ void DQExecutor::StoreResult(ClientContext &context, const DQTestResult &result,
 		insert_sql += "'" + escaped_error + "', ";
 	}
 
-	insert_sql += std::to_string(result.execution_time_ms) + ")";
+	insert_sql += std::to_string(result.execution_time_ms) + ", ";
+	insert_sql += result.strategy.empty() ? "NULL, " : "'" + result.strategy + "', ";
+	insert_sql += result.estimated_rows < 0 ? "NULL)" : std::to_string(result.estimated_rows) + ")";
 	// printf("Storing result for test '%s': %s\n", result.test_name.c_str(), insert_sql.c_str());
 
-	con.Query(insert_sql);
+	pool.Write(insert_sql);
+
+	// Segments go to their own table, keyed by (execution_id, test_id), a few hundred rows per statement
+	static constexpr idx_t SEGMENT_BATCH_SIZE = 500;
+	for (idx_t batch_start = 0; batch_start < result.segments.size(); batch_start += SEGMENT_BATCH_SIZE) {
+		auto batch_end = MinValue<idx_t>(batch_start + SEGMENT_BATCH_SIZE, result.segments.size());
+		string segment_sql = "INSERT INTO dq_test_segment_results (execution_id, test_id, segment, status, "
+		                     "rows_failed, rows_total) VALUES ";
+		for (idx_t i = batch_start; i < batch_end; i++) {
+			auto &segment = result.segments[i];
+			if (i > batch_start) {
+				segment_sql += ", ";
+			}
+			segment_sql += "(" + Value(execution_id).ToSQLString() + ", " + Value(result.test_id).ToSQLString() +
+			               ", " + Value(segment.segment).ToSQLString() + ", '" + segment.status + "', " +
+			               std::to_string(segment.rows_failed) + ", " + std::to_string(segment.rows_total) + ")";
+		}
+		pool.Write(segment_sql);
+	}
 }
 
 } // namespace duckdb
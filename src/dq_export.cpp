@@ -0,0 +1,227 @@
+#include "dq_export.hpp"
+#include "duckdb.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/main/connection.hpp"
+
+namespace duckdb {
+
+struct ExportResultsBindData : public FunctionData {
+	string path;
+	string format = "parquet";
+	Value since; // NULL: continue from the last export to the same path
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto result = make_uniq<ExportResultsBindData>();
+		result->path = path;
+		result->format = format;
+		result->since = since;
+		return result;
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<ExportResultsBindData>();
+		return path == other.path && format == other.format && since == other.since;
+	}
+};
+
+struct ExportResultsGlobalState : public GlobalTableFunctionState {
+	string file;
+	int64_t rows_exported = 0;
+	Value exported_until = Value(LogicalType::TIMESTAMP);
+	bool finished = false;
+
+	idx_t MaxThreads() const override {
+		return 1;
+	}
+};
+
+//! executed_at is the start of the storing transaction, so a result can commit after a later executed_at was already
+//! exported. Each export therefore re-reads this far behind its watermark and skips the result_ids it already wrote.
+static constexpr const char *EXPORT_OVERLAP = "INTERVAL 1 HOUR";
+
+static unique_ptr<FunctionData> ExportResultsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                  vector<LogicalType> &return_types, vector<string> &names) {
+	auto bind_data = make_uniq<ExportResultsBindData>();
+	if (input.inputs[0].IsNull()) {
+		throw InvalidInputException("dq_export_results: path cannot be NULL");
+	}
+	bind_data->path = StringValue::Get(input.inputs[0]);
+
+	for (auto &kv : input.named_parameters) {
+		if (kv.second.IsNull()) {
+			continue;
+		}
+		if (kv.first == "format") {
+			bind_data->format = StringUtil::Lower(StringValue::Get(kv.second));
+		} else if (kv.first == "since") {
+			bind_data->since = kv.second;
+		}
+	}
+	if (bind_data->format != "parquet" && bind_data->format != "arrow") {
+		throw InvalidInputException("dq_export_results: format must be 'parquet' or 'arrow'");
+	}
+	// 'arrow' writes an Arrow IPC stream through the ARROWS copy format, which only the arrow extension registers
+	if (bind_data->format == "arrow" &&
+	    !Catalog::GetEntry(context, CatalogType::COPY_FUNCTION_ENTRY, SYSTEM_CATALOG, DEFAULT_SCHEMA, "arrows",
+	                       OnEntryNotFound::RETURN_NULL)) {
+		throw InvalidInputException(
+		    "dq_export_results: format 'arrow' needs the arrow extension (INSTALL arrow FROM community; LOAD arrow)");
+	}
+
+	names.push_back("path");
+	names.push_back("file");
+	names.push_back("format");
+	names.push_back("rows_exported");
+	names.push_back("exported_until");
+
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::BIGINT);
+	return_types.push_back(LogicalType::TIMESTAMP);
+
+	return bind_data;
+}
+
+static unique_ptr<MaterializedQueryResult> RunExportQuery(Connection &con, const string &sql, const string &action) {
+	auto result = con.Query(sql);
+	if (result->HasError()) {
+		auto error = result->GetError();
+		con.Query("ROLLBACK");
+		throw InvalidInputException("Error " + action + ": " + error);
+	}
+	return result;
+}
+
+static unique_ptr<GlobalTableFunctionState> ExportResultsGlobalInit(ClientContext &context,
+                                                                    TableFunctionInitInput &input) {
+	auto state = make_uniq<ExportResultsGlobalState>();
+	auto &bind_data = input.bind_data->Cast<ExportResultsBindData>();
+
+	Connection con(DatabaseInstance::GetDatabase(context));
+	auto path_literal = Value(bind_data.path).ToSQLString();
+
+	// Selection, file and log entry all come from one snapshot
+	RunExportQuery(con, "BEGIN TRANSACTION", "starting export");
+
+	// Without an explicit since, continue where the previous export to this path stopped
+	string selection;
+	if (!bind_data.since.IsNull()) {
+		selection = "r.executed_at > " + bind_data.since.DefaultCastAs(LogicalType::TIMESTAMP).ToSQLString();
+	} else {
+		auto last_export = RunExportQuery(
+		    con, "SELECT MAX(exported_until) FROM dq_export_log WHERE path = " + path_literal, "reading export log");
+		auto chunk = last_export->Fetch();
+		if (chunk && chunk->size() > 0 && !chunk->GetValue(0, 0).IsNull()) {
+			selection = "r.executed_at > " + chunk->GetValue(0, 0).ToSQLString() + " - " + EXPORT_OVERLAP +
+			            " AND r.result_id NOT IN (SELECT result_id FROM dq_export_seen WHERE path = " + path_literal +
+			            ")";
+		} else {
+			selection = "true";
+		}
+	}
+
+	auto bound = RunExportQuery(con, "SELECT MAX(r.executed_at) FROM dq_test_results r WHERE " + selection,
+	                            "reading results to export");
+	auto bound_chunk = bound->Fetch();
+	if (!bound_chunk || bound_chunk->size() == 0 || bound_chunk->GetValue(0, 0).IsNull()) {
+		con.Query("ROLLBACK");
+		return state;
+	}
+	auto until = bound_chunk->GetValue(0, 0);
+	auto until_literal = until.ToSQLString();
+
+	// Each increment goes to its own numbered file under path, so a consumer never loses an unread delta. Claiming
+	// the number updates the path's row, so of two concurrent exports to one path the later one fails with a
+	// write-write conflict instead of exporting the same results again.
+	RunExportQuery(con,
+	               "INSERT INTO dq_export_paths (path, parts) SELECT " + path_literal +
+	                   ", COUNT(*) + 1 FROM dq_export_log WHERE path = " + path_literal +
+	                   " ON CONFLICT (path) DO UPDATE SET parts = parts + 1",
+	               "claiming the next file under " + bind_data.path);
+	auto parts = RunExportQuery(con, "SELECT parts FROM dq_export_paths WHERE path = " + path_literal,
+	                            "claiming the next file under " + bind_data.path);
+	auto part_number = parts->Fetch()->GetValue(0, 0).GetValue<int64_t>();
+	auto part_name = std::to_string(part_number);
+	part_name.insert(0, part_name.size() < 5 ? 5 - part_name.size() : 0, '0');
+	// Two exports that claim a new path at once only conflict at commit, after both wrote their file. The random
+	// suffix keeps them from writing to the same file, so the one that fails can remove its own.
+	part_name += "-" + UUID::ToString(UUID::GenerateRandomUUID()).substr(0, 8);
+
+	auto &fs = FileSystem::GetFileSystem(context);
+	if (!fs.DirectoryExists(bind_data.path)) {
+		fs.CreateDirectory(bind_data.path);
+	}
+	state->file =
+	    fs.JoinPath(bind_data.path, "part-" + part_name + (bind_data.format == "parquet" ? ".parquet" : ".arrows"));
+	auto file_literal = Value(state->file).ToSQLString();
+
+	string copy_format = bind_data.format == "parquet" ? "PARQUET" : "ARROWS";
+	string copy_sql = "COPY (SELECT r.result_id, r.execution_id, r.test_id, t.test_name, t.table_name, t.column_name, "
+	                  "t.test_type, t.severity, r.status, r.rows_failed, r.rows_total, r.execution_time_ms, r.strategy, "
+	                  "r.estimated_rows, r.error_message, r.compiled_sql, r.executed_at FROM dq_test_results r "
+	                  "LEFT JOIN dq_tests t ON t.test_id = r.test_id WHERE " +
+	                  selection + " ORDER BY r.executed_at) TO " + file_literal + " (FORMAT " + copy_format + ")";
+	try {
+		auto copy_result = RunExportQuery(con, copy_sql, "exporting results");
+		auto copy_chunk = copy_result->Fetch();
+		if (copy_chunk && copy_chunk->size() > 0) {
+			state->rows_exported = copy_chunk->GetValue(0, 0).GetValue<int64_t>();
+		}
+		state->exported_until = until;
+
+		// Remember what was written within the overlap window, and forget what fell out of it
+		RunExportQuery(con,
+		               "INSERT INTO dq_export_seen (path, result_id, executed_at) SELECT " + path_literal +
+		                   ", r.result_id, r.executed_at FROM dq_test_results r WHERE " + selection,
+		               "recording exported results");
+		RunExportQuery(con,
+		               "DELETE FROM dq_export_seen WHERE path = " + path_literal + " AND executed_at <= " +
+		                   until_literal + " - " + EXPORT_OVERLAP,
+		               "recording exported results");
+		RunExportQuery(con,
+		               "INSERT INTO dq_export_log (path, file, format, exported_until, rows_exported) VALUES (" +
+		                   path_literal + ", " + file_literal + ", '" + bind_data.format + "', " + until_literal +
+		                   ", " + std::to_string(state->rows_exported) + ")",
+		               "recording export");
+		RunExportQuery(con, "COMMIT", "committing export");
+	} catch (std::exception &) {
+		// The log never names a file of a failed export, so no consumer can be pointed at it
+		fs.TryRemoveFile(state->file);
+		throw;
+	}
+
+	return state;
+}
+
+static void ExportResultsFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<ExportResultsGlobalState>();
+	auto &bind_data = data.bind_data->Cast<ExportResultsBindData>();
+
+	if (global_state.finished) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	output.SetCardinality(1);
+	output.data[0].SetValue(0, Value(bind_data.path));
+	output.data[1].SetValue(0, global_state.file.empty() ? Value() : Value(global_state.file));
+	output.data[2].SetValue(0, Value(bind_data.format));
+	output.data[3].SetValue(0, Value::BIGINT(global_state.rows_exported));
+	output.data[4].SetValue(0, global_state.exported_until);
+	global_state.finished = true;
+}
+
+void RegisterDQExportFunctions(ExtensionLoader &loader) {
+	TableFunction export_func("dq_export_results", {LogicalType::VARCHAR}, ExportResultsFunc, ExportResultsBind,
+	                          ExportResultsGlobalInit);
+	export_func.named_parameters["since"] = LogicalType::TIMESTAMP;
+	export_func.named_parameters["format"] = LogicalType::VARCHAR;
+	loader.RegisterFunction(export_func);
+}
+
+} // namespace duckdb
@@ -1,8 +1,13 @@
 #include "dq_functions.hpp"
 #include "dq_executor.hpp"
+#include "dq_metrics.hpp"
+#include "dq_compiler.hpp"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/main/connection.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/statement/select_statement.hpp"
+#include "duckdb/parser/tableref/subqueryref.hpp"
 #include <vector>
 #include <chrono>
 
@@ -27,6 +32,7 @@ struct RunTestsBindData : public FunctionData {
 	string table_name_filter;
 	string tag_filter;
 	string test_id_filter;
+	DQRunOptions options;
 
 	RunTestsBindData() {
 	}
@@ -36,13 +42,18 @@ struct RunTestsBindData : public FunctionData {
 		result->table_name_filter = table_name_filter;
 		result->tag_filter = tag_filter;
 		result->test_id_filter = test_id_filter;
+		result->options = options;
 		return result;
 	}
 
 	bool Equals(const FunctionData &other_p) const override {
 		auto &other = other_p.Cast<RunTestsBindData>();
 		return table_name_filter == other.table_name_filter && tag_filter == other.tag_filter &&
-		       test_id_filter == other.test_id_filter;
+		       test_id_filter == other.test_id_filter &&
+		       options.materialize_views == other.options.materialize_views &&
+		       options.sample_threshold.IsValid() == other.options.sample_threshold.IsValid() &&
+		       (!options.sample_threshold.IsValid() ||
+		        options.sample_threshold.GetIndex() == other.options.sample_threshold.GetIndex());
 	}
 };
 
@@ -58,6 +69,10 @@ unique_ptr<FunctionData> RunTestsBind(ClientContext &context, TableFunctionBindI
 			bind_data->tag_filter = StringValue::Get(kv.second);
 		} else if (kv.first == "test_id") {
 			bind_data->test_id_filter = StringValue::Get(kv.second);
+		} else if (kv.first == "materialize_views") {
+			bind_data->options.materialize_views = BooleanValue::Get(kv.second);
+		} else if (kv.first == "sample_threshold" && !kv.second.IsNull()) {
+			bind_data->options.sample_threshold = optional_idx(kv.second.GetValue<idx_t>());
 		}
 	}
 
@@ -95,77 +110,19 @@ static unique_ptr<GlobalTableFunctionState> RunTestsGlobalInit(ClientContext &co
 	auto state = make_uniq<RunTestsGlobalState>();
 	auto &bind_data = input.bind_data->Cast<RunTestsBindData>();
 
-	Connection con(context.db->GetDatabase(context));
-
-	// Build query to fetch tests
-	string query = "SELECT test_id, test_name, table_name, column_name, test_type, test_params, severity, warn_if, "
-	               "error_if FROM dq_tests WHERE enabled = true";
-
-	if (!bind_data.test_id_filter.empty()) {
-		// printf("Filtering by test_id: %s\n", bind_data.test_id_filter.c_str());
-		query += " AND test_id = '" + bind_data.test_id_filter + "'";
-		// printf("Final query: %s\n", query.c_str());
-	} else {
-		if (!bind_data.table_name_filter.empty()) {
-			// printf("Filtering by table_name: %s\n", bind_data.table_name_filter.c_str());
-			query += " AND table_name = '" + bind_data.table_name_filter + "'";
-			// printf("Final query: %s\n", query.c_str());
-		}
-		if (!bind_data.tag_filter.empty()) {
-			// printf("Filtering by tag: %s\n", bind_data.tag_filter.c_str());
-			query += " AND '" + bind_data.tag_filter + "' = ANY(tags)";
-			// printf("Final query: %s\n", query.c_str());
-		}
-	}
+	auto &db = DatabaseInstance::GetDatabase(context);
+	Connection con(db);
 
-	auto result = con.Query(query);
-
-	if (result->HasError()) {
-		throw InvalidInputException("Error fetching tests: " + result->GetError());
-	}
+	DQTestFilter filter;
+	filter.table_name = bind_data.table_name_filter;
+	filter.tag = bind_data.tag_filter;
+	filter.test_id = bind_data.test_id_filter;
 
-	// Generate execution ID for this batch using SQL
-	auto uuid_result = con.Query("SELECT gen_random_uuid()::VARCHAR");
-	string execution_id;
-	if (!uuid_result->HasError()) {
-		auto uuid_chunk = uuid_result->Fetch();
-		if (uuid_chunk && uuid_chunk->size() > 0) {
-			execution_id = uuid_chunk->GetValue(0, 0).ToString();
-		}
-	} else {
-		// Fallback to timestamp-based ID if UUID generation fails
-		execution_id = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-	}
-
-	// Execute all tests
-	while (true) {
-		auto chunk = result->Fetch();
-		if (!chunk || chunk->size() == 0) {
-			break;
-		}
-
-		for (idx_t i = 0; i < chunk->size(); i++) {
-			string test_id = chunk->GetValue(0, i).ToString();
-			string test_name = chunk->GetValue(1, i).ToString();
-			string table_name = chunk->GetValue(2, i).ToString();
-			string column_name = chunk->GetValue(3, i).IsNull() ? "" : chunk->GetValue(3, i).ToString();
-			string test_type = chunk->GetValue(4, i).ToString();
-			string test_params = chunk->GetValue(5, i).IsNull() ? "{}" : chunk->GetValue(5, i).ToString();
-			string severity = chunk->GetValue(6, i).ToString();
-			string warn_if = chunk->GetValue(7, i).IsNull() ? "" : chunk->GetValue(7, i).ToString();
-			string error_if = chunk->GetValue(8, i).IsNull() ? "" : chunk->GetValue(8, i).ToString();
-
-			// Execute the test
-			auto test_result = DQExecutor::ExecuteTest(context, test_id, test_name, table_name, column_name, test_type,
-			                                           test_params, severity, warn_if, error_if);
-
-			// Store result in database
-			DQExecutor::StoreResult(context, test_result, execution_id);
-
-			// Add to results vector
-			state->results.push_back(test_result);
-		}
-	}
+	auto tests = DQExecutor::LoadTests(con, filter);
+	auto execution_id = DQExecutor::GenerateExecutionId(con);
+	auto options = bind_data.options;
+	options.metrics_path = DQMetrics::GetMetricsPath(context);
+	state->results = DQExecutor::RunSuite(context.db, tests, execution_id, nullptr, options);
 
 	return state;
 }
@@ -178,22 +135,35 @@ void RunTestsFunc(ClientContext &context, TableFunctionInput &data, DataChunk &o
 		return;
 	}
 
+	// Fill the flat vectors directly instead of boxing every cell in a Value
+	auto string_cell = [&](idx_t col, idx_t row, const string &value, bool null_if_empty) {
+		auto &vector = output.data[col];
+		if (null_if_empty && value.empty()) {
+			FlatVector::SetNull(vector, row, true);
+			return;
+		}
+		FlatVector::GetData<string_t>(vector)[row] = StringVector::AddString(vector, value);
+	};
+	auto rows_failed_data = FlatVector::GetData<int64_t>(output.data[6]);
+	auto rows_total_data = FlatVector::GetData<int64_t>(output.data[7]);
+	auto execution_time_data = FlatVector::GetData<int64_t>(output.data[9]);
+
 	idx_t count = 0;
 	while (global_state.current_idx < global_state.results.size() && count < STANDARD_VECTOR_SIZE) {
 		auto &result = global_state.results[global_state.current_idx];
 
-		output.data[0].SetValue(count, Value(result.test_id));
-		output.data[1].SetValue(count, Value(result.test_name));
-		output.data[2].SetValue(count, Value(result.table_name));
-		output.data[3].SetValue(count, result.column_name.empty() ? Value() : Value(result.column_name));
-		output.data[4].SetValue(count, Value(result.test_type));
-		output.data[5].SetValue(count, Value(result.status));
-		output.data[6].SetValue(count, Value::BIGINT(result.rows_failed));
-		output.data[7].SetValue(count, Value::BIGINT(result.rows_total));
-		output.data[8].SetValue(count, Value(result.compiled_sql));
-		output.data[9].SetValue(count, Value::BIGINT(result.execution_time_ms));
-		output.data[10].SetValue(count, Value(result.severity));
-		output.data[11].SetValue(count, result.error_message.empty() ? Value() : Value(result.error_message));
+		string_cell(0, count, result.test_id, false);
+		string_cell(1, count, result.test_name, false);
+		string_cell(2, count, result.table_name, false);
+		string_cell(3, count, result.column_name, true);
+		string_cell(4, count, result.test_type, false);
+		string_cell(5, count, result.status, false);
+		rows_failed_data[count] = result.rows_failed;
+		rows_total_data[count] = result.rows_total;
+		string_cell(8, count, result.compiled_sql, false);
+		execution_time_data[count] = result.execution_time_ms;
+		string_cell(10, count, result.severity, false);
+		string_cell(11, count, result.error_message, true);
 
 		global_state.current_idx++;
 		count++;
@@ -202,6 +172,61 @@ void RunTestsFunc(ClientContext &context, TableFunctionInput &data, DataChunk &o
 	output.SetCardinality(count);
 }
 
+// dq_failed_rows is replaced at bind time by the test's compiled SQL as a subquery, so the failing rows stream
+// through the regular pipeline with their real types and projection/filter pushdown applies
+static unique_ptr<TableRef> FailedRowsBindReplace(ClientContext &context, TableFunctionBindInput &input) {
+	if (input.inputs[0].IsNull()) {
+		throw InvalidInputException("dq_failed_rows: test_id cannot be NULL");
+	}
+
+	DQTestFilter filter;
+	filter.test_id = StringValue::Get(input.inputs[0]);
+
+	Connection con(DatabaseInstance::GetDatabase(context));
+	auto tests = DQExecutor::LoadTests(con, filter);
+	if (tests.empty()) {
+		throw InvalidInputException("dq_failed_rows: no enabled test with test_id '" + filter.test_id + "'");
+	}
+	auto &test = tests[0];
+	if (DQCompiler::IsDriftTest(test.test_type)) {
+		throw InvalidInputException("dq_failed_rows: drift test '" + test.test_name + "' does not fail on rows");
+	}
+
+	string sql = DQCompiler::CompileTest(test.test_type, test.table_name, test.column_name, test.test_params);
+
+	string limit;
+	string offset;
+	for (auto &kv : input.named_parameters) {
+		if (kv.second.IsNull()) {
+			continue;
+		}
+		if (kv.first == "limit") {
+			limit = std::to_string(kv.second.GetValue<int64_t>());
+		} else if (kv.first == "offset") {
+			offset = std::to_string(kv.second.GetValue<int64_t>());
+		}
+	}
+	if (!limit.empty() || !offset.empty()) {
+		// Neither aggregates nor parallel scans keep their order between calls, so pages need a total order
+		sql = "SELECT * FROM (" + sql + ") AS dq_failed_rows ORDER BY ALL";
+		if (!limit.empty()) {
+			sql += " LIMIT " + limit;
+		}
+		if (!offset.empty()) {
+			sql += " OFFSET " + offset;
+		}
+	}
+
+	Parser parser(context.GetParserOptions());
+	parser.ParseQuery(sql);
+	if (parser.statements.size() != 1 || parser.statements[0]->type != StatementType::SELECT_STATEMENT) {
+		throw InvalidInputException("dq_failed_rows: compiled SQL of test '" + test.test_name +
+		                            "' is not a single SELECT statement");
+	}
+	auto select = unique_ptr_cast<SQLStatement, SelectStatement>(std::move(parser.statements[0]));
+	return make_uniq<SubqueryRef>(std::move(select));
+}
+
 void RegisterDQFunctions(ExtensionLoader &loader) {
 	// Register run_tests table function
 	TableFunction run_tests_func("dq_run_tests", {}, RunTestsFunc, RunTestsBind, RunTestsGlobalInit);
@@ -210,8 +235,18 @@ void RegisterDQFunctions(ExtensionLoader &loader) {
 	run_tests_func.named_parameters["table_name"] = LogicalType::VARCHAR;
 	run_tests_func.named_parameters["tag"] = LogicalType::VARCHAR;
 	run_tests_func.named_parameters["test_id"] = LogicalType::VARCHAR;
+	run_tests_func.named_parameters["materialize_views"] = LogicalType::BOOLEAN;
+	run_tests_func.named_parameters["sample_threshold"] = LogicalType::UBIGINT;
 
 	loader.RegisterFunction(run_tests_func);
+
+	// Register failed_rows table function
+	TableFunction failed_rows_func("dq_failed_rows", {LogicalType::VARCHAR}, nullptr, nullptr);
+	failed_rows_func.bind_replace = FailedRowsBindReplace;
+	failed_rows_func.named_parameters["limit"] = LogicalType::BIGINT;
+	failed_rows_func.named_parameters["offset"] = LogicalType::BIGINT;
+
+	loader.RegisterFunction(failed_rows_func);
 }
 
 } // namespace duckdb
@@ -0,0 +1,140 @@
+#include "dq_materializer.hpp"
+#include "dq_compiler.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/connection.hpp"
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace duckdb {
+
+DQViewMaterializer::DQViewMaterializer(DQConnectionPool &pool, const string &execution_id) : pool(pool) {
+	catalog_name = "dq_views_" + StringUtil::Replace(execution_id, "-", "_");
+}
+
+DQViewMaterializer::~DQViewMaterializer() {
+	if (attached) {
+		pool.Write("DETACH DATABASE IF EXISTS " + catalog_name);
+	}
+}
+
+vector<DQTestDefinition> DQViewMaterializer::Materialize(const vector<DQTestDefinition> &tests) {
+	vector<DQTestDefinition> result = tests;
+
+	// Views can be referenced with or without their schema
+	std::set<string> view_names;
+	auto views = pool.Write("SELECT schema_name, view_name FROM duckdb_views() WHERE NOT internal");
+	if (views->HasError()) {
+		return result;
+	}
+	while (true) {
+		auto chunk = views->Fetch();
+		if (!chunk || chunk->size() == 0) {
+			break;
+		}
+		for (idx_t i = 0; i < chunk->size(); i++) {
+			auto schema_name = chunk->GetValue(0, i).ToString();
+			auto view_name = chunk->GetValue(1, i).ToString();
+			view_names.insert(StringUtil::Lower(view_name));
+			view_names.insert(StringUtil::Lower(schema_name + "." + view_name));
+		}
+	}
+
+	// Columns each view must keep; custom_sql can reference anything, so it keeps them all
+	std::map<string, std::set<string>> view_columns;
+	std::set<string> keep_all_columns;
+	for (auto &test : tests) {
+		if (test.test_type == "relationship") {
+			auto to_table = DQCompiler::ExtractStringParam(test.test_params, "to_table");
+			auto to_column = DQCompiler::ExtractStringParam(test.test_params, "to_column");
+			if (view_names.count(StringUtil::Lower(to_table)) > 0 && !to_column.empty()) {
+				view_columns[to_table].insert(to_column);
+			}
+		}
+		if (view_names.count(StringUtil::Lower(test.table_name)) == 0) {
+			continue;
+		}
+		auto &columns = view_columns[test.table_name];
+		if (test.test_type == "custom_sql") {
+			keep_all_columns.insert(test.table_name);
+		}
+		if (!test.column_name.empty()) {
+			columns.insert(test.column_name);
+		}
+		for (auto &column : StringUtil::Split(test.group_by, ',')) {
+			StringUtil::Trim(column);
+			if (!column.empty()) {
+				columns.insert(column);
+			}
+		}
+	}
+	if (view_columns.empty()) {
+		return result;
+	}
+
+	auto attach_result = pool.Write("ATTACH ':memory:' AS " + catalog_name);
+	if (attach_result->HasError()) {
+		return result;
+	}
+	attached = true;
+
+	unordered_map<string, string> copy_names;
+	idx_t view_idx = 0;
+	for (auto &entry : view_columns) {
+		auto &view_name = entry.first;
+		string select_list;
+		if (keep_all_columns.count(view_name) > 0) {
+			select_list = "*";
+		} else if (entry.second.empty()) {
+			// Only row counts are needed
+			select_list = "NULL::BOOLEAN AS __dq_row";
+		} else {
+			for (auto &column : entry.second) {
+				if (!select_list.empty()) {
+					select_list += ", ";
+				}
+				select_list += column;
+			}
+		}
+
+		string copy_name = catalog_name + ".main.view_" + std::to_string(view_idx++);
+		auto create_result = pool.Write("CREATE TABLE " + copy_name + " AS SELECT " + select_list + " FROM " + view_name);
+		if (create_result->HasError()) {
+			continue;
+		}
+		copy_names[view_name] = copy_name;
+		original_names[copy_name] = view_name;
+	}
+
+	for (auto &test : result) {
+		auto entry = copy_names.find(test.table_name);
+		if (entry != copy_names.end()) {
+			test.table_name = entry->second;
+		}
+		if (test.test_type == "relationship") {
+			auto parent = copy_names.find(DQCompiler::ExtractStringParam(test.test_params, "to_table"));
+			if (parent != copy_names.end()) {
+				test.test_params = DQCompiler::ReplaceStringParam(test.test_params, "to_table", parent->second);
+			}
+		}
+	}
+	return result;
+}
+
+void DQViewMaterializer::RestoreNames(DQTestResult &result) const {
+	auto entry = original_names.find(result.table_name);
+	if (entry != original_names.end()) {
+		result.table_name = entry->second;
+	}
+	// The SQL can name several copies (a relationship test's parent), and view_1 is a prefix of view_10
+	vector<std::pair<string, string>> names(original_names.begin(), original_names.end());
+	std::sort(names.begin(), names.end(), [](const std::pair<string, string> &a, const std::pair<string, string> &b) {
+		return a.first.size() > b.first.size();
+	});
+	for (auto &name : names) {
+		result.compiled_sql = StringUtil::Replace(result.compiled_sql, name.first, name.second);
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,302 @@
+#include "dq_metrics.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// DQLatencyHistogram
+//===--------------------------------------------------------------------===//
+idx_t DQLatencyHistogram::BucketIndex(uint64_t value) {
+	// Values below 4 get their own bucket; above that, each power of two is split into four linear sub-buckets
+	if (value < 4) {
+		return static_cast<idx_t>(value);
+	}
+	idx_t msb = 0;
+	for (uint64_t v = value; v > 1; v >>= 1) {
+		msb++;
+	}
+	idx_t sub_bucket = static_cast<idx_t>((value >> (msb - 2)) & 3);
+	return (msb - 1) * 4 + sub_bucket;
+}
+
+uint64_t DQLatencyHistogram::BucketUpperBound(idx_t index) {
+	if (index < 4) {
+		return index;
+	}
+	idx_t msb = index / 4 + 1;
+	idx_t sub_bucket = index % 4;
+	uint64_t lower = static_cast<uint64_t>(4 + sub_bucket) << (msb - 2);
+	return lower + (static_cast<uint64_t>(1) << (msb - 2)) - 1;
+}
+
+void DQLatencyHistogram::Record(uint64_t value) {
+	buckets[BucketIndex(value)]++;
+	count++;
+	sum += value;
+	auto current_max = max.load();
+	while (value > current_max && !max.compare_exchange_weak(current_max, value)) {
+	}
+}
+
+uint64_t DQLatencyHistogram::Quantile(double quantile) const {
+	auto total = Count();
+	if (total == 0) {
+		return 0;
+	}
+	auto target = static_cast<uint64_t>(quantile * static_cast<double>(total));
+	if (target == 0) {
+		target = 1;
+	}
+	uint64_t seen = 0;
+	for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets[i].load();
+		if (seen >= target) {
+			return MinValue<uint64_t>(BucketUpperBound(i), Max());
+		}
+	}
+	return Max();
+}
+
+//===--------------------------------------------------------------------===//
+// DQMetrics
+//===--------------------------------------------------------------------===//
+DQMetrics &DQMetrics::Get() {
+	// Never destroyed: background runs may still record into it while static destructors run at exit
+	static DQMetrics *metrics = new DQMetrics();
+	return *metrics;
+}
+
+string DQMetrics::GetMetricsPath(ClientContext &context) {
+	Value path;
+	if (!context.TryGetCurrentSetting("dq_metrics_path", path) || path.IsNull()) {
+		return string();
+	}
+	return path.ToString();
+}
+
+const vector<string> &DQMetrics::TestTypes() {
+	// Anything unknown is counted as 'other', so the counter table stays fixed-size and lock-free
+	static const vector<string> test_types = {"unique",
+	                                          "not_null",
+	                                          "accepted_values",
+	                                          "regex",
+	                                          "range",
+	                                          "relationship",
+	                                          "row_count",
+	                                          "custom_sql",
+	                                          "mean_drift",
+	                                          "quantile_drift",
+	                                          "null_rate_drift",
+	                                          "distinct_count_drift",
+	                                          "top_k_drift",
+	                                          "other"};
+	return test_types;
+}
+
+const vector<string> &DQMetrics::Statuses() {
+	static const vector<string> statuses = {"pass", "warn", "fail", "skipped"};
+	return statuses;
+}
+
+void DQMetrics::RecordTest(const string &test_type, const string &status, int64_t execution_time_ms) {
+	auto &test_types = TestTypes();
+	idx_t type_idx = test_types.size() - 1;
+	for (idx_t i = 0; i < test_types.size(); i++) {
+		if (test_types[i] == test_type) {
+			type_idx = i;
+			break;
+		}
+	}
+	auto &statuses = Statuses();
+	for (idx_t i = 0; i < statuses.size(); i++) {
+		if (statuses[i] == status) {
+			tests_executed[type_idx][i]++;
+			break;
+		}
+	}
+	if (status != "skipped") {
+		test_latency_us.Record(static_cast<uint64_t>(MaxValue<int64_t>(execution_time_ms, 0)) * 1000);
+	}
+}
+
+static void AddHistogramSamples(vector<DQMetricSample> &samples, const string &name,
+                                const DQLatencyHistogram &histogram) {
+	static const double quantiles[] = {0.5, 0.9, 0.99};
+	for (auto quantile : quantiles) {
+		std::ostringstream label;
+		label << "quantile=\"" << quantile << "\"";
+		samples.push_back({name, label.str(), "summary", static_cast<double>(histogram.Quantile(quantile))});
+	}
+	samples.push_back({name, "quantile=\"1\"", "summary", static_cast<double>(histogram.Max())});
+	samples.push_back({name + "_sum", "", "summary", static_cast<double>(histogram.Sum())});
+	samples.push_back({name + "_count", "", "summary", static_cast<double>(histogram.Count())});
+}
+
+vector<DQMetricSample> DQMetrics::Snapshot() const {
+	vector<DQMetricSample> samples;
+	auto &test_types = TestTypes();
+	auto &statuses = Statuses();
+	for (idx_t t = 0; t < test_types.size(); t++) {
+		for (idx_t s = 0; s < statuses.size(); s++) {
+			auto value = tests_executed[t][s].load();
+			if (value == 0) {
+				continue;
+			}
+			samples.push_back({"dq_tests_executed_total",
+			                   "test_type=\"" + test_types[t] + "\",status=\"" + statuses[s] + "\"", "counter",
+			                   static_cast<double>(value)});
+		}
+	}
+	samples.push_back({"dq_rows_scanned_total", "", "counter", static_cast<double>(rows_scanned.load())});
+	samples.push_back({"dq_shared_scan_total", "result=\"hit\"", "counter",
+	                   static_cast<double>(shared_scan_hits.load())});
+	samples.push_back({"dq_shared_scan_total", "result=\"miss\"", "counter",
+	                   static_cast<double>(shared_scan_misses.load())});
+	samples.push_back({"dq_metrics_dump_errors_total", "", "counter", static_cast<double>(dump_errors.load())});
+	AddHistogramSamples(samples, "dq_test_latency_us", test_latency_us);
+	AddHistogramSamples(samples, "dq_queue_wait_us", queue_wait_us);
+	AddHistogramSamples(samples, "dq_store_latency_us", store_latency_us);
+	AddHistogramSamples(samples, "dq_run_latency_us", run_latency_us);
+	return samples;
+}
+
+//! Counters, sums and latencies are whole numbers and are printed with every digit, so rate() stays exact
+static string FormatSampleValue(double value) {
+	if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+		return std::to_string(static_cast<int64_t>(value));
+	}
+	std::ostringstream out;
+	out << std::setprecision(17) << value;
+	return out.str();
+}
+
+string DQMetrics::RenderPrometheus() const {
+	std::ostringstream out;
+	string last_family;
+	for (auto &sample : Snapshot()) {
+		// _sum and _count belong to the summary family declared just before them
+		auto family = sample.name;
+		for (auto suffix : {"_sum", "_count"}) {
+			auto suffix_len = strlen(suffix);
+			if (family.size() > suffix_len && family.compare(family.size() - suffix_len, suffix_len, suffix) == 0 &&
+			    sample.type == "summary") {
+				family = family.substr(0, family.size() - suffix_len);
+			}
+		}
+		if (family != last_family) {
+			out << "# TYPE " << family << " " << sample.type << "\n";
+			last_family = family;
+		}
+		out << sample.name;
+		if (!sample.labels.empty()) {
+			out << "{" << sample.labels << "}";
+		}
+		out << " " << FormatSampleValue(sample.value) << "\n";
+	}
+	return out.str();
+}
+
+void DQMetrics::VerifyMetricsPath(DBConfig &config, const string &path) {
+	// The same check DuckDB's own file functions make: enable_external_access, allowed_directories and allowed_paths
+	for (auto &file : {path, path + ".tmp"}) {
+		if (!config.CanAccessFile(file, FileType::FILE_TYPE_REGULAR)) {
+			throw PermissionException("Cannot write DQ metrics to \"%s\": file system access is disabled by configuration",
+			                          file);
+		}
+	}
+}
+
+void DQMetrics::DumpPrometheus(DatabaseInstance &db, const string &path) const {
+	VerifyMetricsPath(DBConfig::GetConfig(db), path);
+	auto &fs = FileSystem::GetFileSystem(db);
+	auto temp_path = path + ".tmp";
+	auto rendered = RenderPrometheus();
+	{
+		auto handle = fs.OpenFile(temp_path, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+		handle->Write(const_cast<char *>(rendered.data()), rendered.size());
+		handle->Sync();
+	}
+	fs.MoveFile(temp_path, path);
+}
+
+void DQMetrics::TryDumpPrometheus(DatabaseInstance &db, const string &path) {
+	try {
+		DumpPrometheus(db, path);
+	} catch (std::exception &e) {
+		dump_errors++;
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// dq_metrics
+//===--------------------------------------------------------------------===//
+struct MetricsGlobalState : public GlobalTableFunctionState {
+	vector<DQMetricSample> samples;
+	idx_t current_idx = 0;
+
+	idx_t MaxThreads() const override {
+		return 1;
+	}
+};
+
+static unique_ptr<FunctionData> MetricsBind(ClientContext &context, TableFunctionBindInput &input,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+	names.push_back("metric");
+	names.push_back("labels");
+	names.push_back("type");
+	names.push_back("value");
+
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::VARCHAR);
+	return_types.push_back(LogicalType::DOUBLE);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> MetricsGlobalInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<MetricsGlobalState>();
+	state->samples = DQMetrics::Get().Snapshot();
+	return state;
+}
+
+static void MetricsFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &global_state = data.global_state->Cast<MetricsGlobalState>();
+
+	idx_t count = 0;
+	while (global_state.current_idx < global_state.samples.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &sample = global_state.samples[global_state.current_idx];
+		output.data[0].SetValue(count, Value(sample.name));
+		output.data[1].SetValue(count, sample.labels.empty() ? Value() : Value(sample.labels));
+		output.data[2].SetValue(count, Value(sample.type));
+		output.data[3].SetValue(count, Value::DOUBLE(sample.value));
+		global_state.current_idx++;
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+static void SetMetricsPath(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && !parameter.ToString().empty()) {
+		DQMetrics::VerifyMetricsPath(DBConfig::GetConfig(context), parameter.ToString());
+	}
+}
+
+void RegisterDQMetricsFunctions(ExtensionLoader &loader) {
+	TableFunction metrics_func("dq_metrics", {}, MetricsFunc, MetricsBind, MetricsGlobalInit);
+	loader.RegisterFunction(metrics_func);
+
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption("dq_metrics_path",
+	                          "File that receives DQ metrics in Prometheus text format after every test run",
+	                          LogicalType::VARCHAR, Value(""), SetMetricsPath);
+}
+
+} // namespace duckdb
@@ -0,0 +1,161 @@
+#include "dq_optimizer.hpp"
+#include "dq_compiler.hpp"
+#include "dq_metrics.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/main/connection.hpp"
+#include <chrono>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace duckdb {
+
+vector<DQOptimizer::SharedScan> DQOptimizer::PlanSharedScans(const vector<DQTestDefinition> &tests,
+                                                             const vector<DQTestPlan> &plans,
+                                                             const vector<idx_t> &depths) {
+	// Columns that need a GROUP BY because a unique test is defined on them, per DAG depth
+	std::set<std::tuple<idx_t, string, string>> grouped_columns;
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto &test = tests[i];
+		if (test.test_type == "unique" && !test.column_name.empty() && plans[i].strategy == "exact") {
+			grouped_columns.insert(std::make_tuple(depths[i], test.table_name, test.column_name));
+		}
+	}
+
+	// Ordered maps keep the generated SQL deterministic between runs
+	std::map<std::tuple<idx_t, string, string>, SharedScan> grouped_scans;
+	std::map<std::pair<idx_t, string>, SharedScan> flat_scans;
+	std::map<std::tuple<idx_t, string, string>, vector<string>> grouped_aggregates;
+	std::map<std::pair<idx_t, string>, vector<string>> flat_aggregates;
+	// Relationship tests per DAG depth and parent column
+	std::map<std::tuple<idx_t, string, string>, vector<idx_t>> relationships;
+
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto &test = tests[i];
+		if (!test.group_by.empty() || plans[i].strategy != "exact" || depths[i] == DConstants::INVALID_INDEX) {
+			// Segmented tests run their own grouped pass, planned tests their own strategy
+			continue;
+		}
+		if (test.test_type == "relationship") {
+			auto to_table = DQCompiler::ExtractStringParam(test.test_params, "to_table");
+			auto to_column = DQCompiler::ExtractStringParam(test.test_params, "to_column");
+			if (!to_table.empty() && !to_column.empty() && !test.column_name.empty()) {
+				relationships[std::make_tuple(depths[i], to_table, to_column)].push_back(i);
+			}
+			continue;
+		}
+		auto key = std::make_tuple(depths[i], test.table_name, test.column_name);
+		auto table_key = std::make_pair(depths[i], test.table_name);
+		bool grouped = grouped_columns.count(key) > 0;
+
+		string aggregate;
+		try {
+			aggregate = DQCompiler::CompileFailureAggregate(test.test_type, test.column_name, test.test_params, grouped);
+		} catch (std::exception &e) {
+			// Invalid parameters: let the regular execution path report the error for this test
+			continue;
+		}
+		if (aggregate.empty()) {
+			continue;
+		}
+
+		if (grouped) {
+			grouped_scans[key].table_name = test.table_name;
+			grouped_scans[key].test_indexes.push_back(i);
+			grouped_aggregates[key].push_back(aggregate);
+		} else {
+			flat_scans[table_key].table_name = test.table_name;
+			flat_scans[table_key].test_indexes.push_back(i);
+			flat_aggregates[table_key].push_back(aggregate);
+		}
+	}
+
+	vector<SharedScan> scans;
+	for (auto &entry : grouped_scans) {
+		auto &column_name = std::get<2>(entry.first);
+		auto &scan = entry.second;
+		scan.sql = "SELECT COALESCE(SUM(__dq_cnt), 0)";
+		for (auto &aggregate : grouped_aggregates[entry.first]) {
+			scan.sql += ", " + aggregate;
+		}
+		scan.sql += " FROM (SELECT " + column_name + ", COUNT(*) AS __dq_cnt FROM " + scan.table_name + " GROUP BY " +
+		            column_name + ")";
+		scans.push_back(std::move(scan));
+	}
+	for (auto &entry : flat_scans) {
+		auto &scan = entry.second;
+		scan.sql = "SELECT COUNT(*)";
+		for (auto &aggregate : flat_aggregates[entry.first]) {
+			scan.sql += ", " + aggregate;
+		}
+		scan.sql += " FROM " + scan.table_name;
+		scans.push_back(std::move(scan));
+	}
+	for (auto &entry : relationships) {
+		auto &test_indexes = entry.second;
+		if (test_indexes.size() < 2) {
+			// A single check reads the parent once anyway
+			continue;
+		}
+		SharedScan scan;
+		scan.table_name = std::get<1>(entry.first);
+		scan.test_indexes = test_indexes;
+		scan.per_test_totals = true;
+		// Each child table is joined once against the distinct parent keys, which keeps its row count intact
+		scan.sql = "WITH __dq_keys AS MATERIALIZED (SELECT DISTINCT " + std::get<2>(entry.first) +
+		           " AS __dq_key FROM " + scan.table_name + ") SELECT * FROM ";
+		for (idx_t i = 0; i < test_indexes.size(); i++) {
+			auto &test = tests[test_indexes[i]];
+			auto suffix = std::to_string(i);
+			if (i > 0) {
+				scan.sql += ", ";
+			}
+			scan.sql += "(SELECT COUNT(*) AS __dq_total_" + suffix + ", COUNT(*) FILTER (WHERE t." + test.column_name +
+			            " IS NOT NULL AND k.__dq_key IS NULL) AS __dq_failed_" + suffix + " FROM " + test.table_name +
+			            " t LEFT JOIN __dq_keys k ON k.__dq_key = t." + test.column_name + ") AS __dq_child_" + suffix;
+		}
+		scans.push_back(std::move(scan));
+	}
+	return scans;
+}
+
+void DQOptimizer::ExecuteSharedScan(DQConnectionPool &pool, const SharedScan &scan, DQSharedScanResults &results) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto con = pool.AcquireReader();
+	auto scan_result = con.Query(scan.sql);
+	if (scan_result->HasError()) {
+		// Fall back to executing these tests one by one so each gets its own error message
+		return;
+	}
+	auto chunk = scan_result->Fetch();
+	if (!chunk || chunk->size() == 0) {
+		return;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	// The scan's cost is split evenly across the tests it answered
+	auto per_test_ms = elapsed_ms / static_cast<int64_t>(scan.test_indexes.size());
+
+	auto rows_total = chunk->GetValue(0, 0).GetValue<int64_t>();
+	if (!scan.per_test_totals) {
+		DQMetrics::Get().RecordRowsScanned(rows_total);
+	}
+	for (idx_t i = 0; i < scan.test_indexes.size(); i++) {
+		DQSharedCounts counts;
+		if (scan.per_test_totals) {
+			counts.rows_total = chunk->GetValue(2 * i, 0).GetValue<int64_t>();
+			counts.rows_failed = chunk->GetValue(2 * i + 1, 0).GetValue<int64_t>();
+			DQMetrics::Get().RecordRowsScanned(counts.rows_total);
+		} else {
+			counts.rows_failed = chunk->GetValue(i + 1, 0).GetValue<int64_t>();
+			counts.rows_total = rows_total;
+		}
+		counts.execution_time_ms = per_test_ms;
+		results.tests[scan.test_indexes[i]] = counts;
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,221 @@
+#include "dq_planner.hpp"
+#include "dq_compiler.hpp"
+#include "dq_metrics.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/case_insensitive_map.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/connection.hpp"
+#include <chrono>
+#include <cmath>
+
+namespace duckdb {
+
+Value DQPlanner::QueryScalar(DQConnectionPool &pool, const string &sql) {
+	auto con = pool.AcquireReader();
+	auto result = con.Query(sql);
+	if (result->HasError()) {
+		// Planning is best effort: a failed lookup just means the test runs exactly
+		return Value();
+	}
+	auto chunk = result->Fetch();
+	if (!chunk || chunk->size() == 0) {
+		return Value();
+	}
+	return chunk->GetValue(0, 0);
+}
+
+DQPlanner::TableStats DQPlanner::LoadTableStats(DQConnectionPool &pool, const string &table_name) {
+	TableStats stats;
+
+	// Only plain [[database.]schema.]table names can be found in the catalog; anything else has no estimate
+	auto parts = StringUtil::Split(table_name, '.');
+	if (parts.empty() || parts.size() > 3) {
+		return stats;
+	}
+	// Resolve the name like the binder does, so a table of the same name in another schema or database is never used
+	string filter = "table_name = " + Value(parts.back()).ToSQLString();
+	if (parts.size() == 1) {
+		filter += " AND database_name = current_database() AND schema_name = current_schema()";
+	} else if (parts.size() == 2) {
+		// schema.table in the current database, otherwise database.table in that database's default schema
+		auto qualifier = Value(parts[0]).ToSQLString();
+		auto in_current_database = "database_name = current_database() AND schema_name = " + qualifier;
+		auto found =
+		    QueryScalar(pool, "SELECT COUNT(*) FROM duckdb_tables() WHERE " + filter + " AND " + in_current_database);
+		if (!found.IsNull() && found.GetValue<int64_t>() > 0) {
+			filter += " AND " + in_current_database;
+		} else {
+			filter += " AND database_name = " + qualifier + " AND schema_name = 'main'";
+		}
+	} else {
+		filter += " AND schema_name = " + Value(parts[1]).ToSQLString() +
+		          " AND database_name = " + Value(parts[0]).ToSQLString();
+	}
+
+	// The estimate the optimizer itself uses for a scan of the table; views have none
+	auto estimate = QueryScalar(pool, "SELECT MAX(estimated_size) FROM duckdb_tables() WHERE " + filter);
+	if (!estimate.IsNull()) {
+		stats.estimated_rows = estimate.GetValue<int64_t>();
+	}
+
+	auto con = pool.AcquireReader();
+	auto constraints = con.Query("SELECT constraint_type, constraint_column_names[1], referenced_table, "
+	                             "referenced_column_names[1] FROM duckdb_constraints() WHERE " +
+	                             filter + " AND len(constraint_column_names) = 1");
+	if (constraints->HasError()) {
+		return stats;
+	}
+	// A UNIQUE constraint still admits several NULLs, so it only proves uniqueness together with NOT NULL
+	vector<string> unique_constraint_columns;
+	case_insensitive_set_t not_null_columns;
+	while (auto chunk = constraints->Fetch()) {
+		if (chunk->size() == 0) {
+			break;
+		}
+		for (idx_t row = 0; row < chunk->size(); row++) {
+			auto constraint_type = chunk->GetValue(0, row).ToString();
+			auto column_name = chunk->GetValue(1, row).ToString();
+			if (constraint_type == "PRIMARY KEY") {
+				stats.unique_columns.push_back(column_name);
+			} else if (constraint_type == "UNIQUE") {
+				unique_constraint_columns.push_back(column_name);
+			} else if (constraint_type == "NOT NULL") {
+				not_null_columns.insert(column_name);
+			} else if (constraint_type == "FOREIGN KEY" && !chunk->GetValue(2, row).IsNull()) {
+				stats.foreign_keys.push_back(column_name + "->" + chunk->GetValue(2, row).ToString() + "." +
+				                             chunk->GetValue(3, row).ToString());
+			}
+		}
+	}
+	for (auto &column_name : unique_constraint_columns) {
+		if (not_null_columns.count(column_name) > 0) {
+			stats.unique_columns.push_back(column_name);
+		}
+	}
+	return stats;
+}
+
+bool DQPlanner::ColumnHasNoNulls(DQConnectionPool &pool, const string &table_name, const string &column_name) {
+	// stats() reports the statistics the planner propagates for the column, e.g. "[Has Null: false, ...]". They are
+	// conservative: a deleted or updated NULL may still be counted, but a NULL is never missed.
+	auto stats = QueryScalar(pool, "SELECT stats(" + column_name + ") FROM " + table_name + " LIMIT 1");
+	if (stats.IsNull()) {
+		return false;
+	}
+	return StringUtil::Contains(StringUtil::Lower(stats.ToString()), "has null: false");
+}
+
+vector<DQTestPlan> DQPlanner::PlanTests(DQConnectionPool &pool, const vector<DQTestDefinition> &tests,
+                                        const DQRunOptions &options) {
+	vector<DQTestPlan> plans(tests.size());
+	unordered_map<string, TableStats> table_stats;
+
+	for (idx_t i = 0; i < tests.size(); i++) {
+		auto &test = tests[i];
+		auto &plan = plans[i];
+		if (DQCompiler::IsDriftTest(test.test_type) || test.test_type == "custom_sql") {
+			// Drift tests are already sketches; custom SQL is opaque to the planner
+			continue;
+		}
+
+		auto entry = table_stats.find(test.table_name);
+		if (entry == table_stats.end()) {
+			entry = table_stats.emplace(test.table_name, LoadTableStats(pool, test.table_name)).first;
+		}
+		auto &stats = entry->second;
+		plan.estimated_rows = stats.estimated_rows;
+
+		if (!test.group_by.empty() || test.column_name.empty()) {
+			// Segment counts and row_count tests need the exact pass
+			continue;
+		}
+
+		if (test.test_type == "unique") {
+			for (auto &column : stats.unique_columns) {
+				if (StringUtil::CIEquals(column, test.column_name)) {
+					plan.strategy = "statistics";
+				}
+			}
+		} else if (test.test_type == "relationship") {
+			auto to_table = DQCompiler::ExtractStringParam(test.test_params, "to_table");
+			auto to_column = DQCompiler::ExtractStringParam(test.test_params, "to_column");
+			auto expected = test.column_name + "->" + to_table + "." + to_column;
+			for (auto &foreign_key : stats.foreign_keys) {
+				if (StringUtil::CIEquals(foreign_key, expected)) {
+					plan.strategy = "statistics";
+				}
+			}
+		} else if (test.test_type == "not_null" && ColumnHasNoNulls(pool, test.table_name, test.column_name)) {
+			plan.strategy = "statistics";
+		}
+
+		if (plan.strategy == "exact" && DQCompiler::IsPredicateTest(test.test_type) &&
+		    options.sample_threshold.IsValid() && stats.estimated_rows > 0 &&
+		    static_cast<idx_t>(stats.estimated_rows) > options.sample_threshold.GetIndex()) {
+			plan.strategy = "sample";
+			plan.sample_rows = options.sample_threshold.GetIndex();
+		}
+	}
+	return plans;
+}
+
+DQTestResult DQPlanner::ExecutePlannedTest(DQConnectionPool &pool, const DQTestDefinition &test,
+                                           const DQTestPlan &plan) {
+	auto start = std::chrono::high_resolution_clock::now();
+	int64_t rows_total = 0;
+	int64_t rows_failed = 0;
+	bool planned = true;
+	{
+		// Both strategies need the exact row count, which reads no column data
+		auto con = pool.AcquireReader();
+		auto count_result = con.Query("SELECT COUNT(*) FROM " + test.table_name);
+		if (count_result->HasError()) {
+			planned = false;
+		} else {
+			auto count_chunk = count_result->Fetch();
+			if (count_chunk && count_chunk->size() > 0) {
+				rows_total = count_chunk->GetValue(0, 0).GetValue<int64_t>();
+			}
+		}
+
+		if (planned && plan.strategy == "sample" && rows_total > 0) {
+			auto predicate = DQCompiler::CompileFailurePredicate(test.test_type, test.column_name, test.test_params);
+			// System sampling skips whole vectors, so only about the requested share of the table is read
+			auto percentage = MinValue<double>(100.0, 100.0 * static_cast<double>(plan.sample_rows) /
+			                                              static_cast<double>(rows_total));
+			auto sample_result = con.Query("SELECT COUNT(*), COUNT(*) FILTER (WHERE " + predicate + ") FROM " +
+			                               test.table_name + " USING SAMPLE " + std::to_string(percentage) +
+			                               " PERCENT (system)");
+			unique_ptr<DataChunk> sample_chunk;
+			if (!sample_result->HasError()) {
+				sample_chunk = sample_result->Fetch();
+			}
+			int64_t sampled = 0;
+			if (sample_chunk && sample_chunk->size() > 0) {
+				sampled = sample_chunk->GetValue(0, 0).GetValue<int64_t>();
+			}
+			if (sampled == 0) {
+				// No usable sample: fall back to the exact test
+				planned = false;
+			} else {
+				auto sample_failed = sample_chunk->GetValue(1, 0).GetValue<int64_t>();
+				auto scale = static_cast<double>(rows_total) / static_cast<double>(sampled);
+				rows_failed = static_cast<int64_t>(std::llround(static_cast<double>(sample_failed) * scale));
+				DQMetrics::Get().RecordRowsScanned(sampled);
+			}
+		}
+	}
+	// The reader is released first: ExecuteTest acquires its own
+	if (!planned) {
+		return DQExecutor::ExecuteTest(pool, test);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	auto result = DQExecutor::ResolveTest(test, rows_failed, rows_total, elapsed_ms);
+	result.strategy = plan.strategy;
+	return result;
+}
+
+} // namespace duckdb
@@ -43,11 +43,16 @@ static unique_ptr<GlobalTableFunctionState> DQInitGlobalInit(ClientContext &cont
 				error_if VARCHAR,
 				warn_if VARCHAR,
 				tags VARCHAR[],
+				depends_on VARCHAR[],
+				group_by VARCHAR,
 				enabled BOOLEAN DEFAULT true,
 				description VARCHAR,
 				created_at TIMESTAMP DEFAULT now(),
 				updated_at TIMESTAMP DEFAULT now()
 			))",
+		    // Columns added after the first release, for databases initialized by an older version
+		    "ALTER TABLE dq_tests ADD COLUMN IF NOT EXISTS depends_on VARCHAR[]",
+		    "ALTER TABLE dq_tests ADD COLUMN IF NOT EXISTS group_by VARCHAR",
 		    R"(CREATE TABLE IF NOT EXISTS dq_test_results (
 				result_id VARCHAR PRIMARY KEY DEFAULT gen_random_uuid()::VARCHAR,
 				test_id VARCHAR NOT NULL,
@@ -61,8 +66,50 @@ static unique_ptr<GlobalTableFunctionState> DQInitGlobalInit(ClientContext &cont
 				execution_time_ms INTEGER,
 				executed_at TIMESTAMP DEFAULT now()
 			))",
+		    R"(CREATE TABLE IF NOT EXISTS dq_test_segment_results (
+				execution_id VARCHAR NOT NULL,
+				test_id VARCHAR NOT NULL,
+				segment VARCHAR NOT NULL,
+				status VARCHAR NOT NULL,
+				rows_failed BIGINT,
+				rows_total BIGINT
+			))",
+		    R"(CREATE TABLE IF NOT EXISTS dq_test_profiles (
+				profile_id VARCHAR PRIMARY KEY DEFAULT gen_random_uuid()::VARCHAR,
+				test_id VARCHAR NOT NULL,
+				execution_id VARCHAR NOT NULL,
+				status VARCHAR NOT NULL,
+				rows_total BIGINT,
+				metric_value DOUBLE,
+				metric_text VARCHAR,
+				profiled_at TIMESTAMP DEFAULT now()
+			))",
+		    R"(CREATE TABLE IF NOT EXISTS dq_export_log (
+				path VARCHAR NOT NULL,
+				file VARCHAR,
+				format VARCHAR NOT NULL,
+				exported_until TIMESTAMP NOT NULL,
+				rows_exported BIGINT,
+				exported_at TIMESTAMP DEFAULT now()
+			))",
+		    R"(CREATE TABLE IF NOT EXISTS dq_export_seen (
+				path VARCHAR NOT NULL,
+				result_id VARCHAR NOT NULL,
+				executed_at TIMESTAMP NOT NULL
+			))",
+		    R"(CREATE TABLE IF NOT EXISTS dq_export_paths (
+				path VARCHAR PRIMARY KEY,
+				parts BIGINT NOT NULL
+			))",
+		    "ALTER TABLE dq_test_results ADD COLUMN IF NOT EXISTS strategy VARCHAR",
+		    "ALTER TABLE dq_test_results ADD COLUMN IF NOT EXISTS estimated_rows BIGINT",
+		    "ALTER TABLE dq_test_profiles ADD COLUMN IF NOT EXISTS accepted BOOLEAN DEFAULT false",
 		    "CREATE INDEX IF NOT EXISTS idx_dq_test_results_test_id ON dq_test_results(test_id)",
 		    "CREATE INDEX IF NOT EXISTS idx_dq_test_results_execution_id ON dq_test_results(execution_id)",
+		    "CREATE INDEX IF NOT EXISTS idx_dq_test_segment_results_execution_id ON "
+		    "dq_test_segment_results(execution_id)",
+		    "CREATE INDEX IF NOT EXISTS idx_dq_test_profiles_test_id ON dq_test_profiles(test_id)",
+		    "CREATE INDEX IF NOT EXISTS idx_dq_test_results_executed_at ON dq_test_results(executed_at)",
 		    "CREATE INDEX IF NOT EXISTS idx_dq_tests_table_name ON dq_tests(table_name)",
 		    "CREATE INDEX IF NOT EXISTS idx_dq_tests_enabled ON dq_tests(enabled)"};
 
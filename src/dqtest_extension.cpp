@@ -9,12 +9,20 @@
 // Include function headers
 #include "dq_schema.hpp"
 #include "dq_functions.hpp"
+#include "dq_async.hpp"
+#include "dq_export.hpp"
+#include "dq_metrics.hpp"
+#include "dq_drift.hpp"
 namespace duckdb {
 
 static void LoadInternal(ExtensionLoader &loader) {
 
-	RegisterDQSchemaFunctions(loader); // dq_init
-	RegisterDQFunctions(loader);       // dq_run_tests + dq_run_test
+	RegisterDQSchemaFunctions(loader);  // dq_init
+	RegisterDQFunctions(loader);        // dq_run_tests + dq_failed_rows
+	RegisterDQAsyncFunctions(loader);   // dq_run_tests_async + dq_execution_status + dq_cancel + dq_wait
+	RegisterDQExportFunctions(loader);  // dq_export_results
+	RegisterDQMetricsFunctions(loader); // dq_metrics + dq_metrics_path setting
+	RegisterDQDriftFunctions(loader);   // dq_accept_drift
 }
 
 void DqtestExtension::Load(ExtensionLoader &loader) {
@@ -10,6 +10,33 @@ public:
 	static string CompileTest(const string &test_type, const string &table_name, const string &column_name,
 	                          const string &test_params_json);
 
+	//! Whether the test's failures can be expressed as a row-level predicate on its column
+	static bool IsPredicateTest(const string &test_type);
+	//! Row-level predicate that is true for the rows a predicate test reports as failing
+	static string CompileFailurePredicate(const string &test_type, const string &column_name,
+	                                      const string &test_params_json);
+	//! Aggregate expression counting the test's failures inside a shared scan, or "" if the test can't share one.
+	//! When grouped, the scan input is (column_name, __dq_cnt) from GROUP BY column_name; otherwise the raw table.
+	static string CompileFailureAggregate(const string &test_type, const string &column_name,
+	                                      const string &test_params_json, bool grouped);
+
+	//! Per-segment variant of a test: one grouped pass returning (segment, rows_failed, rows_total) per group of the
+	//! comma-separated group_by columns
+	static string CompileSegmentedTest(const string &test_type, const string &table_name, const string &column_name,
+	                                   const string &test_params_json, const string &group_by);
+
+	//! Whether the test compares a column profile against its history instead of checking rows
+	static bool IsDriftTest(const string &test_type);
+	//! Aggregate expression that computes the profile metric a drift test tracks, in a single pass
+	static string CompileDriftMetric(const string &test_type, const string &column_name,
+	                                 const string &test_params_json);
+
+	static string ExtractNumericParam(const string &test_params_json, const string &key, const string &default_value);
+	//! Extracts a quoted string parameter, or "" when the key is absent
+	static string ExtractStringParam(const string &test_params_json, const string &key);
+	//! Replaces the value of a quoted string parameter; the JSON is returned unchanged when the key is absent
+	static string ReplaceStringParam(const string &test_params_json, const string &key, const string &value);
+
 private:
 	static string CompileUnique(const string &table_name, const string &column_name);
 	static string CompileNotNull(const string &table_name, const string &column_name);
@@ -22,6 +49,11 @@ private:
 	static string CompileRowCount(const string &table_name, const string &test_params_json);
 	static string CompileCustomSQL(const string &table_name, const string &column_name, const string &test_params_json);
 
+	static string ExtractAcceptedValues(const string &test_params_json);
+	static string ExtractRegexPattern(const string &test_params_json);
+	static string CompileRowCountCondition(const string &test_params_json);
+	static string CompileSegmentLabel(const vector<string> &group_columns, const string &qualifier);
+
 	static string SubstituteVariables(const string &sql, const string &table_name, const string &column_name);
 };
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/mutex.hpp"
+#include <string>
+
+namespace duckdb {
+
+class DQConnectionPool;
+
+//! A reader of the pool running one transaction, owned exclusively until it goes out of scope. Every query made
+//! through it sees the same snapshot, so the count and the failure query of a test can't disagree. The transaction
+//! is rolled back on release, so a query error only affects the test that holds the reader.
+class DQPooledConnection {
+public:
+	DQPooledConnection(DQConnectionPool &pool, unique_ptr<Connection> connection);
+	~DQPooledConnection();
+	DQPooledConnection(DQPooledConnection &&other) noexcept = default;
+
+	//! Runs a query in the reader's transaction; fails without running once the database was closed
+	unique_ptr<MaterializedQueryResult> Query(const string &sql);
+
+private:
+	optional_ptr<DQConnectionPool> pool;
+	unique_ptr<Connection> connection;
+};
+
+//! Connections of one suite run. Readers are handed out one per concurrently running test, so the workers of a run
+//! read in parallel; each acquisition of a reader is a transaction of its own. Results are written through an
+//! autocommit connection, so they are persisted as soon as they are stored.
+//! A pool that holds the database keeps its connections open for the whole run and reuses them between tests. A
+//! pool that does not (background runs) only references the database while a query runs, so closing the database
+//! ends the run at its next query instead of being kept open by it.
+class DQConnectionPool {
+public:
+	DQConnectionPool(const weak_ptr<DatabaseInstance> &db, bool hold_database);
+
+	DQPooledConnection AcquireReader();
+	//! Runs a statement on an autocommit connection
+	unique_ptr<MaterializedQueryResult> Write(const string &sql);
+	//! Whether the database was closed under a pool that does not hold it
+	bool DatabaseClosed() const;
+
+private:
+	friend class DQPooledConnection;
+
+	//! Opens a connection, or returns nullptr once the database was closed
+	unique_ptr<Connection> OpenConnection();
+	static unique_ptr<MaterializedQueryResult> ClosedResult();
+
+	weak_ptr<DatabaseInstance> db;
+	shared_ptr<DatabaseInstance> held_db;
+	mutex reader_lock;
+	//! Readers not held by any test; only kept while the pool holds the database
+	vector<unique_ptr<Connection>> idle_readers;
+	mutex writer_lock;
+	unique_ptr<Connection> writer;
+};
+
+} // namespace duckdb
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "dq_executor.hpp"
+#include "dq_connection_pool.hpp"
+#include <string>
+
+namespace duckdb {
+
+//! Drift tests (mean_drift, quantile_drift, null_rate_drift, distinct_count_drift, top_k_drift) profile a column
+//! and compare the profile with a baseline taken from dq_test_profiles instead of rescanning historical data.
+//! Only the finalized metric is persisted, never the sketch behind it: a scalar, or for top_k_drift the top values
+//! with their exact counts. The baseline is the latest profile of the same test from a run in which it passed, or
+//! that was accepted with dq_accept_drift after an expected shift.
+class DQDrift {
+public:
+	//! Profiles the drift tests among test_indexes with one pass per table, evaluates them against their baselines
+	//! and persists the new profiles under execution_id. Returns a result for every drift test among test_indexes.
+	static unordered_map<idx_t, DQTestResult> ExecuteDriftTests(DQConnectionPool &pool,
+	                                                            const vector<DQTestDefinition> &tests,
+	                                                            const vector<idx_t> &test_indexes,
+	                                                            const string &execution_id);
+
+private:
+	struct DriftProfile {
+		bool is_null = true;
+		double value = 0;
+		string text;
+		int64_t rows_total = 0;
+	};
+
+	static DriftProfile ReadProfile(const Value &metric);
+	//! Share of the profiled rows held by each top value of a top_k_drift profile ("value\x1ecount" pairs)
+	static unordered_map<string, double> ReadTopKShares(const DriftProfile &profile);
+	//! Counts each value found by approx_top_k exactly, in one pass over the table for all top_k_drift tests.
+	//! metrics holds the profile scan's values per test; top_k_drift entries are rewritten to "value\x1ecount" pairs.
+	//! Returns an error message, empty on success.
+	static string CountTopKValues(DQPooledConnection &con, const vector<DQTestDefinition> &tests,
+	                              const vector<idx_t> &table_tests, const string &table_name, int64_t rows_total,
+	                              vector<Value> &metrics);
+	//! Size of the change between two profiles: relative for mean, quantile and distinct count, absolute for the
+	//! null rate, and the total variation distance between the frequency shares of the top values for top_k_drift
+	static double ComputeChange(const string &test_type, const DriftProfile &current, const DriftProfile &baseline);
+};
+
+void RegisterDQDriftFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
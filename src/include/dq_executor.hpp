@@ -1,33 +1,113 @@
 #pragma once
 
 #include "duckdb.hpp"
+#include "duckdb/common/atomic.hpp"
+#include "duckdb/common/optional_idx.hpp"
+#include "duckdb/common/optional_ptr.hpp"
 #include <string>
 
 namespace duckdb {
 
+class DQConnectionPool;
+
+struct DQTestDefinition {
+	string test_id;
+	string test_name;
+	string table_name;
+	string column_name;
+	string test_type;
+	string test_params; // JSON
+	string severity;
+	string warn_if;
+	string error_if;
+	//! Explicit prerequisites, by test_id or test_name
+	vector<string> depends_on;
+	//! Comma-separated columns; when set, failures and thresholds are evaluated per segment
+	string group_by;
+};
+
+struct DQTestFilter {
+	string table_name;
+	string tag;
+	string test_id;
+};
+
+struct DQRunOptions {
+	//! Copy each referenced view once per run and point its tests at the copy (see DQViewMaterializer)
+	bool materialize_views = false;
+	//! When set, DQMetrics is dumped to this file in Prometheus text format at the end of the run
+	string metrics_path;
+	//! Predicate tests on tables estimated above this many rows are evaluated on a sample (see DQPlanner)
+	optional_idx sample_threshold;
+	//! Keep the database open for the whole run and reuse connections between tests. Background runs turn it off,
+	//! so closing the database cancels them instead of waiting for them (see DQConnectionPool)
+	bool hold_database = true;
+};
+
+//! Progress of a suite run, readable while the run is in flight (see dq_run_tests_async)
+struct DQRunProgress {
+	atomic<idx_t> tests_done {0};
+	atomic<idx_t> tests_total {0};
+	atomic<bool> cancel_requested {false};
+};
+
+struct DQSegmentResult {
+	string segment; // e.g. "tenant_id=42, region=eu"
+	string status;
+	int64_t rows_failed;
+	int64_t rows_total;
+};
+
 struct DQTestResult {
 	string test_id;
 	string test_name;
 	string table_name;
 	string column_name;
 	string test_type;
-	string status; // 'pass', 'warn', 'fail'
+	string status; // 'pass', 'warn', 'fail', 'skipped'
 	int64_t rows_failed;
 	int64_t rows_total;
 	string compiled_sql;
 	string error_message;
 	int64_t execution_time_ms;
 	string severity;
+	//! Per-segment results of a test with group_by; the test's status is the worst segment status
+	vector<DQSegmentResult> segments;
+	//! How the test was answered: 'exact', 'shared_scan', 'statistics', 'sample' or 'profile' (see DQPlanner)
+	string strategy;
+	//! The planner's row estimate for the test's table, -1 when there is none
+	int64_t estimated_rows;
 };
 
 class DQExecutor {
 public:
-	static DQTestResult ExecuteTest(ClientContext &context, const string &test_id, const string &test_name,
-	                                const string &table_name, const string &column_name, const string &test_type,
-	                                const string &test_params_json, const string &severity, const string &warn_if,
-	                                const string &error_if);
+	//! Loads the enabled tests matching the filter from dq_tests
+	static vector<DQTestDefinition> LoadTests(Connection &con, const DQTestFilter &filter);
+	static string GenerateExecutionId(Connection &con);
+
+	//! Runs a suite and stores each result as soon as it is known. Tests follow the dependency DAG: independent tests
+	//! run in parallel, and a test whose prerequisite failed or was skipped is recorded as 'skipped'. Stops before
+	//! the next test once progress->cancel_requested is set; the results completed so far are returned and stored.
+	//! Also stops once the database is closed, which only happens mid-run when options.hold_database is off.
+	static vector<DQTestResult> RunSuite(const weak_ptr<DatabaseInstance> &db, const vector<DQTestDefinition> &tests,
+	                                     const string &execution_id, optional_ptr<DQRunProgress> progress = nullptr,
+	                                     const DQRunOptions &options = DQRunOptions());
+
+	//! Prerequisites of each test within the suite: its explicit depends_on entries, plus the unique/not_null tests
+	//! on the parent column of a relationship test and the row_count tests on the test's table
+	static vector<vector<idx_t>> ResolveDependencies(const vector<DQTestDefinition> &tests);
+
+	//! Runs a test on its own, counting the table and its failures in one transaction
+	static DQTestResult ExecuteTest(DQConnectionPool &pool, const DQTestDefinition &test);
+
+	//! Runs a test with group_by in one grouped pass and evaluates the thresholds per segment
+	static DQTestResult ExecuteSegmentedTest(DQConnectionPool &pool, const DQTestDefinition &test);
+
+	//! Builds the result of a test whose counts were already computed by a shared scan (see DQOptimizer)
+	static DQTestResult ResolveTest(const DQTestDefinition &test, int64_t rows_failed, int64_t rows_total,
+	                                int64_t execution_time_ms);
 
-	static void StoreResult(ClientContext &context, const DQTestResult &result, const string &execution_id);
+	static void StoreResult(DQConnectionPool &pool, const DQTestResult &result, const string &execution_id);
 
 private:
 	static string DetermineStatus(int64_t rows_failed, int64_t rows_total, const string &severity,
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+void RegisterDQExportFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "dq_executor.hpp"
+#include "dq_connection_pool.hpp"
+#include <string>
+
+namespace duckdb {
+
+//! Copies every view referenced by a run, as a test's table or as the parent of a relationship test, into an
+//! in-memory database attached for the run, keeping only the columns the tests use, so N tests on an expensive view
+//! compute it once. The copies are detached when the materializer is destroyed.
+//! Each copy is taken once when the run starts, so it reflects that point in time rather than the transaction of the
+//! test that reads it: rows committed to a view's tables during the run are not seen by its tests.
+class DQViewMaterializer {
+public:
+	//! The copies are made through the run's pool, which must outlive the materializer
+	DQViewMaterializer(DQConnectionPool &pool, const string &execution_id);
+	~DQViewMaterializer();
+
+	//! Materializes the referenced views and returns the tests rewritten to read the copies. Views that fail to
+	//! materialize are left in place.
+	vector<DQTestDefinition> Materialize(const vector<DQTestDefinition> &tests);
+	//! Puts the original view names back into a result computed against copies
+	void RestoreNames(DQTestResult &result) const;
+
+private:
+	DQConnectionPool &pool;
+	string catalog_name;
+	bool attached = false;
+	//! Qualified copy name -> original view name
+	unordered_map<string, string> original_names;
+};
+
+} // namespace duckdb
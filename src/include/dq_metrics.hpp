@@ -0,0 +1,103 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/atomic.hpp"
+#include <string>
+
+namespace duckdb {
+
+//! Latency histogram with log-linear buckets (four linear sub-buckets per power of two), so any recorded value is
+//! reported within 25% of its true value. Recording is lock-free.
+class DQLatencyHistogram {
+public:
+	static constexpr idx_t BUCKET_COUNT = 256;
+
+	void Record(uint64_t value);
+	uint64_t Count() const {
+		return count.load();
+	}
+	uint64_t Sum() const {
+		return sum.load();
+	}
+	uint64_t Max() const {
+		return max.load();
+	}
+	//! Upper bound of the bucket that holds the given quantile (0 when nothing was recorded)
+	uint64_t Quantile(double quantile) const;
+
+private:
+	static idx_t BucketIndex(uint64_t value);
+	static uint64_t BucketUpperBound(idx_t index);
+
+	atomic<uint64_t> buckets[BUCKET_COUNT] {};
+	atomic<uint64_t> count {0};
+	atomic<uint64_t> sum {0};
+	atomic<uint64_t> max {0};
+};
+
+struct DQMetricSample {
+	string name;
+	string labels; // Prometheus label set without braces, e.g. test_type="unique",status="pass"
+	string type;   // 'counter', 'gauge' or 'summary'
+	double value;
+};
+
+//! Process-wide runtime counters of DQExecutor, exposed by dq_metrics() and optionally dumped in Prometheus text
+//! format to the file named by the dq_metrics_path setting after every run
+class DQMetrics {
+public:
+	static DQMetrics &Get();
+	//! Value of the dq_metrics_path setting, empty when metrics are not dumped
+	static string GetMetricsPath(ClientContext &context);
+
+	void RecordTest(const string &test_type, const string &status, int64_t execution_time_ms);
+	//! Rows read by a query of the run: a test's own query, a shared scan, a drift profile or a sample. Tests
+	//! answered from statistics or from a shared scan read nothing themselves.
+	void RecordRowsScanned(int64_t rows) {
+		rows_scanned += static_cast<uint64_t>(MaxValue<int64_t>(rows, 0));
+	}
+	void RecordQueueWait(uint64_t wait_us) {
+		queue_wait_us.Record(wait_us);
+	}
+	void RecordStore(uint64_t latency_us) {
+		store_latency_us.Record(latency_us);
+	}
+	void RecordRun(uint64_t latency_us) {
+		run_latency_us.Record(latency_us);
+	}
+	//! Tests answered from a shared scan or drift profile, versus tests executed on their own
+	void RecordSharedScan(bool hit) {
+		(hit ? shared_scan_hits : shared_scan_misses)++;
+	}
+
+	vector<DQMetricSample> Snapshot() const;
+	string RenderPrometheus() const;
+	//! Throws a PermissionException unless the database's configuration allows writing the metrics file at path
+	static void VerifyMetricsPath(DBConfig &config, const string &path);
+	//! Writes the Prometheus rendering to path through the database's FileSystem, via a temporary file so scrapers
+	//! never read a partial file
+	void DumpPrometheus(DatabaseInstance &db, const string &path) const;
+	//! DumpPrometheus, counting a failure in dq_metrics_dump_errors_total instead of throwing, so an unwritable
+	//! dq_metrics_path never fails a run whose results are already stored
+	void TryDumpPrometheus(DatabaseInstance &db, const string &path);
+
+private:
+	static const vector<string> &TestTypes();
+	static const vector<string> &Statuses();
+	static constexpr idx_t MAX_TEST_TYPES = 16;
+	static constexpr idx_t MAX_STATUSES = 4;
+
+	atomic<uint64_t> tests_executed[MAX_TEST_TYPES][MAX_STATUSES] {};
+	atomic<uint64_t> rows_scanned {0};
+	atomic<uint64_t> shared_scan_hits {0};
+	atomic<uint64_t> shared_scan_misses {0};
+	atomic<uint64_t> dump_errors {0};
+	DQLatencyHistogram test_latency_us;
+	DQLatencyHistogram queue_wait_us;
+	DQLatencyHistogram store_latency_us;
+	DQLatencyHistogram run_latency_us;
+};
+
+void RegisterDQMetricsFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "dq_executor.hpp"
+#include "dq_connection_pool.hpp"
+#include "dq_planner.hpp"
+#include <string>
+
+namespace duckdb {
+
+struct DQSharedCounts {
+	int64_t rows_failed;
+	int64_t rows_total;
+	int64_t execution_time_ms;
+};
+
+struct DQSharedScanResults {
+	//! Counts per index into the test list, for every test that was answered by a shared scan
+	unordered_map<idx_t, DQSharedCounts> tests;
+};
+
+//! Finds work that several tests of a run have in common and computes it once.
+//! Predicate tests (not_null, accepted_values, regex, range) and row_count tests on the same table are answered by
+//! a single aggregate scan. When a column also carries a unique test, that column's tests are answered by one
+//! GROUP BY over the column instead. Relationship tests that check the same parent column share one materialized
+//! set of its keys, so the parent is read once. Tests that cannot share a scan, or whose shared scan fails, are left to
+//! DQExecutor::ExecuteTest. Tests that DQPlanner answers another way are not part of any scan.
+//! Only tests at the same depth of the dependency DAG share a scan, so a scan runs once its tests' prerequisites
+//! have passed and never computes work for a test that ends up skipped.
+class DQOptimizer {
+public:
+	struct SharedScan {
+		string sql;
+		string table_name;
+		vector<idx_t> test_indexes;
+		//! Whether the scan returns a rows_total column before each test's failures, instead of one rows_total
+		//! column shared by all tests. Set when the tests read different tables.
+		bool per_test_totals = false;
+	};
+
+	//! depths holds each test's depth in the dependency DAG; tests with an invalid depth never run and are left out
+	static vector<SharedScan> PlanSharedScans(const vector<DQTestDefinition> &tests, const vector<DQTestPlan> &plans,
+	                                          const vector<idx_t> &depths);
+	//! Runs one planned scan and adds its counts to results. On failure nothing is added, so the scan's tests fall
+	//! back to running on their own.
+	static void ExecuteSharedScan(DQConnectionPool &pool, const SharedScan &scan, DQSharedScanResults &results);
+};
+
+} // namespace duckdb
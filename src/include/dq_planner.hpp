@@ -0,0 +1,51 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "dq_executor.hpp"
+#include "dq_connection_pool.hpp"
+#include <string>
+
+namespace duckdb {
+
+struct DQTestPlan {
+	//! 'exact', 'statistics' or 'sample'; DQExecutor reports shared-scan and drift answers as 'shared_scan'/'profile'
+	string strategy = "exact";
+	//! The planner's row estimate for the test's table, -1 when there is none (e.g. for a view)
+	int64_t estimated_rows = -1;
+	//! Rows to sample for the 'sample' strategy
+	idx_t sample_rows = 0;
+};
+
+//! Chooses how each test of a run is answered, from the catalog's cardinality estimates, column statistics and
+//! constraints, before any table is scanned:
+//!  - statistics: the answer is implied without reading the column. A not_null column whose statistics hold no NULL,
+//!    a unique column covered by a single-column PRIMARY KEY/UNIQUE constraint, or a relationship backed by a
+//!    matching FOREIGN KEY. Only the table's row count is read.
+//!  - sample: a predicate test on a table estimated above DQRunOptions::sample_threshold rows is evaluated on a
+//!    system sample of about that many rows, and its failure count is scaled to the table.
+//!  - exact: everything else, through the shared scans or the test's compiled SQL.
+class DQPlanner {
+public:
+	//! Returns one plan per test, in the order of tests
+	static vector<DQTestPlan> PlanTests(DQConnectionPool &pool, const vector<DQTestDefinition> &tests,
+	                                    const DQRunOptions &options);
+
+	//! Runs a test whose plan is not 'exact'
+	static DQTestResult ExecutePlannedTest(DQConnectionPool &pool, const DQTestDefinition &test,
+	                                       const DQTestPlan &plan);
+
+private:
+	struct TableStats {
+		int64_t estimated_rows = -1;
+		//! Columns covered by a single-column PRIMARY KEY, or by a UNIQUE constraint on a NOT NULL column
+		vector<string> unique_columns;
+		//! "column->to_table.to_column" for every single-column FOREIGN KEY
+		vector<string> foreign_keys;
+	};
+
+	static Value QueryScalar(DQConnectionPool &pool, const string &sql);
+	static TableStats LoadTableStats(DQConnectionPool &pool, const string &table_name);
+	static bool ColumnHasNoNulls(DQConnectionPool &pool, const string &table_name, const string &column_name);
+};
+
+} // namespace duckdb